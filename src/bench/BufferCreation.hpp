@@ -0,0 +1,113 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/buffers/IBuffer.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace Vulcain::Bench {
+
+// 10k small vertex buffers created then destroyed, sub-allocated by VMA vs a dedicated device allocation each, as done before VMA.
+// The latter is capped by "maxMemoryAllocationCount", the very limit VMA keeps away from
+inline void bufferCreation(Harness& harness) {
+    constexpr uint32_t BUFFERS_COUNT = 10000;
+    constexpr VkDeviceSize BUFFER_SIZE = 4096;
+    constexpr VkBufferUsageFlags USAGE = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    auto &context = harness.gpu();
+    auto &device = context.device;
+    std::cout << BUFFERS_COUNT << " buffers of " << BUFFER_SIZE << " bytes" << std::endl;
+
+    //
+    {
+        std::vector<std::unique_ptr<IBuffer>> buffers;
+        buffers.reserve(BUFFERS_COUNT);
+
+        auto start = Clock::now();
+        for(uint32_t i = 0; i < BUFFERS_COUNT; i++) {
+            buffers.push_back(std::make_unique<IBuffer>(&context.uploads, BUFFER_SIZE, USAGE, VMA_MEMORY_USAGE_GPU_ONLY));
+        }
+        auto createdMs = msSince(start);
+
+        start = Clock::now();
+        buffers.clear();
+        auto destroyedMs = msSince(start);
+
+        std::cout << "VMA : created in " << createdMs << " ms (" << createdMs * 1000 / BUFFERS_COUNT << " us each), destroyed in " << destroyedMs << " ms" << std::endl;
+    }
+
+    // some allocations are already held, eg. VMA blocks
+    constexpr uint32_t ALLOCATIONS_HEADROOM = 64;
+    auto maxAllocations = device.properties().limits.maxMemoryAllocationCount;
+    auto count = std::min(BUFFERS_COUNT, maxAllocations - std::min(maxAllocations, ALLOCATIONS_HEADROOM));
+
+    //
+    struct RawBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+    };
+    std::vector<RawBuffer> buffers(count);
+
+    auto start = Clock::now();
+    for(auto &raw : buffers) {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = BUFFER_SIZE;
+        bufferInfo.usage = USAGE;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        auto result = vkCreateBuffer(device, &bufferInfo, nullptr, &raw.buffer);
+        assert(result == VK_SUCCESS);
+
+        //
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, raw.buffer, &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = device.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        result = vkAllocateMemory(device, &allocInfo, nullptr, &raw.memory);
+        assert(result == VK_SUCCESS);
+
+        result = vkBindBufferMemory(device, raw.buffer, raw.memory, 0);
+        assert(result == VK_SUCCESS);
+    }
+    auto createdMs = msSince(start);
+
+    start = Clock::now();
+    for(auto &raw : buffers) {
+        vkDestroyBuffer(device, raw.buffer, nullptr);
+        vkFreeMemory(device, raw.memory, nullptr);
+    }
+    auto destroyedMs = msSince(start);
+
+    std::cout << "allocation per buffer : " << count << " buffers";
+    if(count < BUFFERS_COUNT) std::cout << " only, capped by maxMemoryAllocationCount (" << maxAllocations << ")";
+    std::cout << ", created in " << createdMs << " ms (" << (count ? createdMs * 1000 / count : 0) << " us each), destroyed in " << destroyedMs << " ms" << std::endl;
+}
+
+} // namespace Vulcain::Bench
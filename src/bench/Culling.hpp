@@ -0,0 +1,89 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/FrustumCuller.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Vulcain::Bench {
+
+// 256k spheres culled by "FrustumCuller", from 1 to all hardware threads. Its instruction set is picked at compile time,
+// so each path has its own executable, eg. "Vulcain-Bench-AVX2" next to the baseline one
+inline void frustumCulling(Harness&) {
+    constexpr uint32_t SPHERES_COUNT = 256 * 1024;
+    constexpr uint32_t ROUNDS = 50;
+
+    // scattered around what the camera looks at
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+
+    std::vector<std::pair<glm::vec3, float>> spheres(SPHERES_COUNT);
+    for(auto &[center, r] : spheres) {
+        center = glm::vec3(position(random), position(random), position(random));
+        r = radius(random);
+    }
+
+    auto view = glm::lookAt(glm::vec3(0.0f, 0.0f, 150.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    auto proj = glm::perspective(glm::radians(60.0f), 16 / 9.0f, 0.1f, 500.0f);
+    auto frustum = Frustum::fromViewProjection(proj * view);
+
+    std::cout << SPHERES_COUNT << " spheres, " << FrustumCuller::instructionSet() << " path, " << ROUNDS << " rounds" << std::endl;
+
+    //
+    auto maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> threadsCounts;
+    for(uint32_t threads = 1; threads < maxThreads; threads *= 2) threadsCounts.push_back(threads);
+    threadsCounts.push_back(maxThreads);
+
+    for(auto threads : threadsCounts) {
+        // a single thread culls from the calling one
+        std::unique_ptr<ThreadPool> pool;
+        if(threads > 1) pool = std::make_unique<ThreadPool>(threads);
+
+        FrustumCuller culler(pool.get());
+        culler.reserve(SPHERES_COUNT);
+        for(auto &[center, r] : spheres) culler.add(center, r);
+
+        // first round warms caches and task results up
+        auto visible = culler.cull(frustum).size();
+
+        double objects = 0;
+        double seconds = 0;
+        for(uint32_t round = 0; round < ROUNDS; round++) {
+            culler.cull(frustum);
+            objects += culler.lastStats().objects;
+            seconds += culler.lastStats().seconds;
+        }
+
+        std::cout << threads << " thread(s) : " << objects / seconds / 1e6 << " M objects/s average, "
+                  << culler.lastStats().objectsPerSecond() / 1e6 << " M objects/s last, " << visible << " visible" << std::endl;
+    }
+}
+
+} // namespace Vulcain::Bench
@@ -0,0 +1,147 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/DrawList.hpp"
+#include "engine/buffers/GeometryHeap.hpp"
+#include "engine/buffers/StaticBuffer.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Vulcain::Bench {
+
+// 20k draws picked at random among 64 quads packed in a "GeometryHeap" and 8 with buffers of their own :
+// recorded in submission order, binding geometry whenever it changes, vs through a "DrawList" sorting and merging them.
+// Reports binds and draws before and after batching, then CPU recording and GPU render pass times
+inline void drawLists(Harness& harness) {
+    constexpr uint32_t HEAP_MESHES_COUNT = 64;
+    constexpr uint32_t OWN_MESHES_COUNT = 8;
+    constexpr uint32_t DRAWS_COUNT = 20000;
+    constexpr uint32_t FRAMES_COUNT = 100;
+    using Vertex = Pipelines::basic::Vertex;
+
+    auto &context = harness.gpu();
+    Offscreen offscreen(context);
+
+    //
+    auto quad = [](uint32_t m, uint32_t meshesCount) {
+        auto half = 0.5f / meshesCount;
+        auto x = -1.0f + 2.0f * (m + 0.5f) / meshesCount;
+        return std::vector<Vertex> {
+            {{x - half, -half}, {1.0f, 0.0f, 0.0f}},
+            {{x + half, -half}, {0.0f, 1.0f, 0.0f}},
+            {{x + half, half}, {0.0f, 0.0f, 1.0f}},
+            {{x - half, half}, {1.0f, 1.0f, 1.0f}}
+        };
+    };
+    const std::vector<uint32_t> indices { 0, 1, 2, 2, 3, 0 };
+
+    //
+    std::vector<DrawList::Geometry> geometries;
+    GeometryHeap<Vertex> heap(&context.uploads, HEAP_MESHES_COUNT * 4, HEAP_MESHES_COUNT * static_cast<uint32_t>(indices.size()));
+    for(uint32_t m = 0; m < HEAP_MESHES_COUNT; m++) {
+        auto mesh = heap.add(quad(m, HEAP_MESHES_COUNT), indices);
+        assert(mesh);
+        geometries.push_back(DrawList::Geometry::of(heap, *mesh));
+    }
+
+    struct OwnMesh {
+        std::unique_ptr<StaticBuffer<Vertex>> vertices;
+        std::unique_ptr<StaticIndexBuffer32> indices;
+    };
+    std::vector<OwnMesh> ownMeshes;
+    for(uint32_t m = 0; m < OWN_MESHES_COUNT; m++) {
+        auto &mesh = ownMeshes.emplace_back(OwnMesh {
+            std::make_unique<StaticBuffer<Vertex>>(&context.uploads, quad(m, OWN_MESHES_COUNT)),
+            std::make_unique<StaticIndexBuffer32>(&context.uploads, indices)
+        });
+        geometries.push_back(DrawList::Geometry::of(*mesh.vertices, *mesh.indices));
+    }
+    context.uploads.waitIdle();
+
+    // same picks every run
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pick(0, geometries.size() - 1);
+    std::vector<const DrawList::Geometry*> draws(DRAWS_COUNT);
+    for(auto &draw : draws) draw = &geometries[pick(random)];
+
+    std::cout << DRAWS_COUNT << " draws among " << geometries.size() << " meshes, over " << FRAMES_COUNT << " frames" << std::endl;
+
+    //
+    auto print = [](const char* name, const FramesStats& stats) {
+        std::cout << name << " : recording " << stats.recordingMs << " ms, GPU " << stats.gpuMs << " ms, frame " << stats.frameMs << " ms" << std::endl;
+    };
+    auto printStats = [](const char* name, const DrawList::Stats& stats) {
+        std::cout << name << " : " << stats.pipelineBinds << " pipeline binds, " << stats.descriptorBinds << " descriptor binds, " 
+                  << stats.geometryBinds << " geometry binds, " << stats.draws << " draws of " << stats.instances << " instances" << std::endl;
+    };
+
+    //
+    {
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame);
+        cmdPool.profile(&offscreen.profiler);
+        cmdPool.record([&offscreen, &draws](VkCommandBuffer cmdBuf, size_t imageIndex) {
+            vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline);
+            vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline.layout(), 0, 1, offscreen.pipeline.descriptorSet(static_cast<uint32_t>(imageIndex)), 0, nullptr);
+
+            const DrawList::Geometry* bound = nullptr;
+            for(auto draw : draws) {
+                if(!bound || bound->vertexBuffer != draw->vertexBuffer || bound->indexBuffer != draw->indexBuffer) {
+                    VkBuffer vertexBuffers[] = {draw->vertexBuffer};
+                    VkDeviceSize offsets[] = {0};
+                    vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+                    vkCmdBindIndexBuffer(cmdBuf, draw->indexBuffer, 0, draw->indexType);
+                    bound = draw;
+                }
+                vkCmdDrawIndexed(cmdBuf, draw->indexCount, 1, draw->firstIndex, draw->vertexOffset, 0);
+            }
+        });
+
+        print("submission order", drawFrames(offscreen, &cmdPool, FRAMES_COUNT));
+    }
+
+    //
+    {
+        DrawList drawList(&context.uploads, offscreen.target.imagesCount());
+
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame);
+        cmdPool.profile(&offscreen.profiler);
+        cmdPool.record([&offscreen, &draws, &drawList](VkCommandBuffer cmdBuf, size_t imageIndex) {
+            DrawList::Material material { *offscreen.pipeline.descriptorSet(static_cast<uint32_t>(imageIndex)) };
+
+            drawList.clear();
+            for(auto draw : draws) {
+                drawList.add(&offscreen.pipeline, *draw, material);
+            }
+            drawList.record(cmdBuf, imageIndex);
+        });
+
+        print("draw list", drawFrames(offscreen, &cmdPool, FRAMES_COUNT));
+        printStats("before batching", drawList.statsBeforeBatching());
+        printStats("after batching", drawList.statsAfterBatching());
+    }
+}
+
+} // namespace Vulcain::Bench
@@ -0,0 +1,141 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/buffers/GeometryHeap.hpp"
+#include "engine/buffers/StaticBuffer.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace Vulcain::Bench {
+
+// 10k small meshes drawn each frame : from their own vertex and index buffers, bound again for each draw,
+// vs packed into a "GeometryHeap" bound once. Reports upload time, then CPU recording and GPU render pass times
+inline void geometryHeap(Harness& harness) {
+    constexpr uint32_t MESHES_COUNT = 10000;
+    constexpr uint32_t GRID_SIZE = 100;
+    constexpr uint32_t QUADS_PER_MESH = 6;
+    constexpr uint32_t FRAMES_COUNT = 100;
+    using Vertex = Pipelines::basic::Vertex;
+
+    auto &context = harness.gpu();
+    Offscreen offscreen(context);
+
+    // a few overlapping quads per grid cell
+    std::vector<std::vector<Vertex>> vertices(MESHES_COUNT);
+    for(uint32_t m = 0; m < MESHES_COUNT; m++) {
+        auto x = -1.0f + 2.0f * (m % GRID_SIZE + 0.5f) / GRID_SIZE;
+        auto y = -1.0f + 2.0f * (m / GRID_SIZE % GRID_SIZE + 0.5f) / GRID_SIZE;
+        for(uint32_t q = 0; q < QUADS_PER_MESH; q++) {
+            auto half = (0.4f + 0.1f * q) / GRID_SIZE;
+            vertices[m].push_back({{x - half, y - half}, {1.0f, 0.0f, 0.0f}});
+            vertices[m].push_back({{x + half, y - half}, {0.0f, 1.0f, 0.0f}});
+            vertices[m].push_back({{x + half, y + half}, {0.0f, 0.0f, 1.0f}});
+            vertices[m].push_back({{x - half, y + half}, {1.0f, 1.0f, 1.0f}});
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    for(uint32_t q = 0; q < QUADS_PER_MESH; q++) {
+        for(auto corner : {0u, 1u, 2u, 2u, 3u, 0u}) indices.push_back(q * 4 + corner);
+    }
+
+    std::cout << MESHES_COUNT << " meshes of " << vertices[0].size() << " vertices and " << indices.size() << " indices, over " << FRAMES_COUNT << " frames" << std::endl;
+
+    //
+    auto print = [](const char* name, double uploadMs, const FramesStats& stats) {
+        std::cout << name << " : uploaded in " << uploadMs << " ms, recording " << stats.recordingMs << " ms, GPU " << stats.gpuMs << " ms, frame " << stats.frameMs << " ms" << std::endl;
+    };
+
+    //
+    {
+        struct Mesh {
+            std::unique_ptr<StaticBuffer<Vertex>> vertices;
+            std::unique_ptr<StaticIndexBuffer32> indices;
+        };
+        std::vector<Mesh> meshes;
+        meshes.reserve(MESHES_COUNT);
+
+        auto start = Clock::now();
+        for(auto &meshVertices : vertices) {
+            meshes.push_back({
+                std::make_unique<StaticBuffer<Vertex>>(&context.uploads, meshVertices),
+                std::make_unique<StaticIndexBuffer32>(&context.uploads, indices)
+            });
+        }
+        context.uploads.waitIdle();
+        auto uploadMs = msSince(start);
+
+        //
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame);
+        cmdPool.profile(&offscreen.profiler);
+        cmdPool.record([&offscreen, &meshes](VkCommandBuffer cmdBuf, size_t imageIndex) {
+            vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline);
+            vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline.layout(), 0, 1, offscreen.pipeline.descriptorSet(static_cast<uint32_t>(imageIndex)), 0, nullptr);
+
+            for(auto &mesh : meshes) {
+                VkBuffer vertexBuffers[] = {mesh.vertices->buffer};
+                VkDeviceSize offsets[] = {0};
+                vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+                vkCmdBindIndexBuffer(cmdBuf, mesh.indices->buffer, 0, VK_INDEX_TYPE_UINT32);
+                vkCmdDrawIndexed(cmdBuf, mesh.indices->vertexCount(), 1, 0, 0, 0);
+            }
+        });
+
+        print("buffers per mesh", uploadMs, drawFrames(offscreen, &cmdPool, FRAMES_COUNT));
+    }
+
+    //
+    {
+        GeometryHeap<Vertex> heap(&context.uploads, MESHES_COUNT * QUADS_PER_MESH * 4, MESHES_COUNT * static_cast<uint32_t>(indices.size()));
+        std::vector<GeometryHeap<Vertex>::Mesh> meshes;
+        meshes.reserve(MESHES_COUNT);
+
+        auto start = Clock::now();
+        for(auto &meshVertices : vertices) {
+            auto mesh = heap.add(meshVertices, indices);
+            assert(mesh);
+            meshes.push_back(std::move(*mesh));
+        }
+        context.uploads.waitIdle();
+        auto uploadMs = msSince(start);
+
+        //
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame);
+        cmdPool.profile(&offscreen.profiler);
+        cmdPool.record([&offscreen, &heap, &meshes](VkCommandBuffer cmdBuf, size_t imageIndex) {
+            vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline);
+            vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline.layout(), 0, 1, offscreen.pipeline.descriptorSet(static_cast<uint32_t>(imageIndex)), 0, nullptr);
+
+            heap.bind(cmdBuf);
+            for(auto &mesh : meshes) {
+                GeometryHeap<Vertex>::draw(cmdBuf, mesh);
+            }
+        });
+
+        print("geometry heap", uploadMs, drawFrames(offscreen, &cmdPool, FRAMES_COUNT));
+    }
+}
+
+} // namespace Vulcain::Bench
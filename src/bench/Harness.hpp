@@ -0,0 +1,116 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "engine/common/Vulcain.h"
+
+#include "engine/Renderer.h"
+#include "engine/Instance.hpp"
+#include "engine/helpers/DevicePicker.hpp"
+#include "engine/helpers/PipelineFactory.hpp"
+#include "engine/buffers/UploadQueue.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+namespace Vulcain::Bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// headless device, as rendering benches would not want a window nor vsync in their way
+struct Context {
+    VkApplicationInfo appInfo = info("Vulcain Bench");
+    InstanceCreateInfo createInfo {&appInfo, true};
+    Instance instance {&createInfo};
+    Device device = DevicePicker::getBestHeadlessDevice(&instance);
+    UploadQueue uploads {&device};
+};
+
+// rendering into offscreen images through the "basic" pipeline, eg. to time draws recording
+struct Offscreen {
+    explicit Offscreen(Context& context, VkExtent2D extent = { 1280, 720 }) : 
+        target(&context.device, extent, RenderSettings::throughput()) {}
+
+    OffscreenTarget target;
+    Renderpass renderpass {&target};
+    DescriptorPools descrPools {&target};
+    PipelineFactory factory {&renderpass, &descrPools};
+    Pipeline pipeline = factory.create<Pipelines::basic>();
+    ImageViews views {&renderpass};
+    GpuProfiler profiler {target.device()};
+};
+
+struct FramesStats {
+    double recordingMs = 0;
+    double gpuMs = 0;
+    double frameMs = 0;
+};
+
+// averages over "framesCount" frames drawn from "cmdPool", which should be profiled by "offscreen.profiler" for GPU time
+inline FramesStats drawFrames(Offscreen& offscreen, CommandPool* cmdPool, uint32_t framesCount) {
+    Renderer renderer(cmdPool, &offscreen.target);
+    renderer.onBeforeWaitingCurrentImage([&offscreen](uint32_t currentImage) {
+        offscreen.pipeline.updateUniformBuffer(currentImage);
+    });
+
+    //
+    FramesStats stats;
+    uint64_t gpuFrames = 0;
+    auto collected = offscreen.profiler.collectedFrames();
+
+    auto start = Clock::now();
+    for(uint32_t frame = 0; frame < framesCount; frame++) {
+        renderer.draw();
+        stats.recordingMs += std::chrono::duration<double, std::milli>(cmdPool->lastRecordingTime()).count();
+
+        // render pass scope comes first
+        if(offscreen.profiler.collectedFrames() == collected || offscreen.profiler.lastResults().empty()) continue;
+        collected = offscreen.profiler.collectedFrames();
+        stats.gpuMs += offscreen.profiler.lastResults().front().ms;
+        gpuFrames++;
+    }
+    vkDeviceWaitIdle(*offscreen.target.device());
+    stats.frameMs = msSince(start) / framesCount;
+
+    //
+    stats.recordingMs /= framesCount;
+    if(gpuFrames) stats.gpuMs /= gpuFrames;
+    return stats;
+}
+
+// what benches are given; the device is only created once a bench asks for it, CPU ones not needing any
+class Harness {
+ public:
+    Context& gpu() {
+        if(!_context) _context = std::make_unique<Context>();
+        return *_context;
+    }
+
+ private:
+    std::unique_ptr<Context> _context;
+};
+
+} // namespace Vulcain::Bench
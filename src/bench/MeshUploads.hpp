@@ -0,0 +1,151 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/buffers/IBuffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace Vulcain::Bench {
+
+// 1000 meshes streamed in, 10 per frame : through "UploadQueue" vs a blocking copy per buffer, as "IBuffer::copyBuffer()" did
+// (single copy submitted, then queue waited for). Reports the time until every mesh is resident, and frames going over a 60 Hz budget
+inline void meshUploads(Harness& harness) {
+    constexpr uint32_t MESHES_COUNT = 1000;
+    constexpr uint32_t MESHES_PER_FRAME = 10;
+    constexpr VkDeviceSize VERTICES_SIZE = 64 * 1024;
+    constexpr VkDeviceSize INDICES_SIZE = 24 * 1024;
+    constexpr double FRAME_BUDGET_MS = 1000.0 / 60;
+
+    auto &context = harness.gpu();
+    auto &device = context.device;
+    std::cout << MESHES_COUNT << " meshes of " << (VERTICES_SIZE + INDICES_SIZE) / 1024 << " KiB, " << MESHES_PER_FRAME << " per frame, hitches over " << FRAME_BUDGET_MS << " ms" << std::endl;
+
+    // content does not matter
+    std::vector<std::byte> vertices(VERTICES_SIZE);
+    std::vector<std::byte> indices(INDICES_SIZE);
+
+    struct Mesh {
+        std::unique_ptr<IBuffer> vertices;
+        std::unique_ptr<IBuffer> indices;
+    };
+
+    // "load" stages a new mesh, "endFrame" tells if every loaded mesh is resident
+    auto stream = [&](const char* name, auto load, auto endFrame) {
+        std::vector<Mesh> meshes;
+        meshes.reserve(MESHES_COUNT);
+        std::vector<double> framesMs;
+
+        //
+        auto start = Clock::now();
+        for(bool resident = false; !resident;) {
+            auto frameStart = Clock::now();
+            for(uint32_t i = 0; i < MESHES_PER_FRAME && meshes.size() < MESHES_COUNT; i++) {
+                auto &mesh = meshes.emplace_back(Mesh {
+                    std::make_unique<IBuffer>(&context.uploads, VERTICES_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY),
+                    std::make_unique<IBuffer>(&context.uploads, INDICES_SIZE, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY)
+                });
+                load(mesh);
+            }
+            resident = endFrame() && meshes.size() == MESHES_COUNT;
+            framesMs.push_back(msSince(frameStart));
+        }
+        auto totalMs = msSince(start);
+
+        //
+        auto hitches = std::count_if(framesMs.begin(), framesMs.end(), [](double ms) { return ms > FRAME_BUDGET_MS; });
+        auto worstMs = *std::max_element(framesMs.begin(), framesMs.end());
+        std::cout << name << " : resident after " << totalMs << " ms over " << framesMs.size() << " frames, worst frame " << worstMs << " ms, " << hitches << " hitches" << std::endl;
+    };
+
+    //
+    stream("upload queue", [&](const Mesh& mesh) {
+        context.uploads.enqueue(vertices.data(), VERTICES_SIZE, *mesh.vertices);
+        context.uploads.enqueue(indices.data(), INDICES_SIZE, *mesh.indices);
+    }, [&]() {
+        context.uploads.flush();
+        context.uploads.poll();
+        return context.uploads.pendingCount() == 0;
+    });
+
+    //
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = static_cast<uint32_t>(device.queueIndex());
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkCommandPool pool;
+    auto result = vkCreateCommandPool(device, &poolInfo, nullptr, &pool);
+    assert(result == VK_SUCCESS);
+
+    auto blockingCopy = [&](const void* data, const IBuffer& dst) {
+        IBuffer staging(&context.uploads, dst.bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, 0, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+        memcpy(staging.mappedData(), data, (size_t) dst.bufferSize);
+
+        //
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = pool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+            VkBufferCopy copyRegion{};
+            copyRegion.size = dst.bufferSize;
+            vkCmdCopyBuffer(commandBuffer, staging.buffer, dst.buffer, 1, &copyRegion);
+
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        vkQueueSubmit(device.queue(), 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(device.queue());
+
+        vkFreeCommandBuffers(device, pool, 1, &commandBuffer);
+    };
+
+    stream("blocking copies", [&](const Mesh& mesh) {
+        blockingCopy(vertices.data(), *mesh.vertices);
+        blockingCopy(indices.data(), *mesh.indices);
+    }, []() {
+        return true;
+    });
+
+    vkDestroyCommandPool(device, pool, nullptr);
+}
+
+} // namespace Vulcain::Bench
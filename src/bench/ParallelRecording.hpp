@@ -0,0 +1,93 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Harness.hpp"
+
+#include "engine/buffers/StaticBuffer.hpp"
+
+#include <array>
+
+namespace Vulcain::Bench {
+
+// tens of thousands of draws recorded each frame, inline vs split into chunks by "recordParallel()" on 1, 2, 4 and 8 threads
+inline void parallelRecording(Harness& harness) {
+    constexpr uint32_t DRAWS_COUNT = 40000;
+    constexpr uint32_t CHUNKS_COUNT = 64;
+    constexpr uint32_t FRAMES_COUNT = 100;
+    using Vertex = Pipelines::basic::Vertex;
+
+    auto &context = harness.gpu();
+    Offscreen offscreen(context);
+    std::cout << DRAWS_COUNT << " draws in " << CHUNKS_COUNT << " chunks, over " << FRAMES_COUNT << " frames" << std::endl;
+
+    // a tiny quad drawn again and again
+    StaticBuffer<Vertex> vertexes(&context.uploads, std::vector<Vertex> {
+        {{-0.01f, -0.01f}, {1.0f, 0.0f, 0.0f}},
+        {{0.01f, -0.01f}, {0.0f, 1.0f, 0.0f}},
+        {{0.01f, 0.01f}, {0.0f, 0.0f, 1.0f}},
+        {{-0.01f, 0.01f}, {1.0f, 1.0f, 1.0f}}
+    });
+    StaticIndexBuffer indexes(&context.uploads, std::vector<uint16_t> {
+        0, 1, 2,
+        2, 3, 0
+    });
+    context.uploads.waitIdle();
+
+    // secondaries inherit nothing but the render pass
+    auto recordDraws = [&offscreen, &vertexes, &indexes](VkCommandBuffer cmdBuf, size_t imageIndex, uint32_t drawsCount) {
+        vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline);
+        vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, offscreen.pipeline.layout(), 0, 1, offscreen.pipeline.descriptorSet(static_cast<uint32_t>(imageIndex)), 0, nullptr);
+
+        VkBuffer vertexBuffers[] = {vertexes.buffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(cmdBuf, indexes.buffer, 0, VK_INDEX_TYPE_UINT16);
+
+        for(uint32_t i = 0; i < drawsCount; i++) {
+            vkCmdDrawIndexed(cmdBuf, indexes.vertexCount(), 1, 0, 0, 0);
+        }
+    };
+
+    //
+    {
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame);
+        cmdPool.record([&recordDraws](VkCommandBuffer cmdBuf, size_t imageIndex) {
+            recordDraws(cmdBuf, imageIndex, DRAWS_COUNT);
+        });
+
+        auto stats = drawFrames(offscreen, &cmdPool, FRAMES_COUNT);
+        std::cout << "inline : recording " << stats.recordingMs << " ms, frame " << stats.frameMs << " ms" << std::endl;
+    }
+
+    //
+    for(uint32_t threads : std::array<uint32_t, 4> { 1, 2, 4, 8 }) {
+        CommandPool cmdPool(&offscreen.views, CommandPool::Mode::PerFrame, threads);
+        cmdPool.recordParallel(CHUNKS_COUNT, [&recordDraws](VkCommandBuffer cmdBuf, size_t imageIndex, uint32_t) {
+            recordDraws(cmdBuf, imageIndex, DRAWS_COUNT / CHUNKS_COUNT);
+        });
+
+        auto stats = drawFrames(offscreen, &cmdPool, FRAMES_COUNT);
+        std::cout << threads << " thread(s) : recording " << stats.recordingMs << " ms, frame " << stats.frameMs << " ms" << std::endl;
+    }
+}
+
+} // namespace Vulcain::Bench
@@ -0,0 +1,79 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#include "Harness.hpp"
+#include "BufferCreation.hpp"
+#include "MeshUploads.hpp"
+#include "GeometryHeapDraws.hpp"
+#include "ParallelRecording.hpp"
+#include "Culling.hpp"
+#include "DrawLists.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <vector>
+
+using namespace Vulcain::Bench;
+
+struct Bench {
+    const char* name;
+    void (*run)(Harness&);
+};
+
+static constexpr std::array BENCHES {
+    Bench { "buffers", &bufferCreation },
+    Bench { "uploads", &meshUploads },
+    Bench { "geometry", &geometryHeap },
+    Bench { "recording", &parallelRecording },
+    Bench { "culling", &frustumCulling },
+    Bench { "drawlist", &drawLists }
+};
+
+int main(int argc, char** argv) {
+    #ifdef USES_VOLK
+    auto result = volkInitialize();
+    assert(result == VK_SUCCESS);
+    #endif
+
+    // eg. "Vulcain-Bench buffers" runs only this one, every bench running if none is named
+    std::vector<std::string_view> selected(argv + 1, argv + argc);
+    for(auto name : selected) {
+        auto exists = std::any_of(BENCHES.begin(), BENCHES.end(), [name](const Bench& bench) { return bench.name == name; });
+        if(exists) continue;
+
+        //
+        std::cerr << "unknown bench \"" << name << "\", available :";
+        for(auto &bench : BENCHES) std::cerr << " " << bench.name;
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    //
+    Harness harness;
+    for(auto &bench : BENCHES) {
+        if(selected.size() && std::find(selected.begin(), selected.end(), bench.name) == selected.end()) continue;
+
+        std::cout << "== " << bench.name << " ==" << std::endl;
+        bench.run(harness);
+    }
+
+    return 0;
+}
@@ -20,27 +20,151 @@
 #pragma once
 
 #include <functional>
+#include <chrono>
+#include <memory>
+#include <map>
 
 #include "ImageViews.hpp"
+#include "GpuProfiler.hpp"
+#include "common/ThreadPool.hpp"
 
 namespace Vulcain {
 
 class CommandPool : public DeviceBound, public IRegenerable {
  public:
     using RecordCallback = std::function<void(VkCommandBuffer, size_t)>;
+    // primary command buffer, image index
+    using PrologueCallback = std::function<void(VkCommandBuffer, size_t)>;
+    // secondary command buffer, image index, chunk index
+    using ChunkRecordCallback = std::function<void(VkCommandBuffer, size_t, uint32_t)>;
 
-    CommandPool(ImageViews* views) : DeviceBound(views), IRegenerable(views), _views(views) {       
-        _createCommandPool();
+    enum class Mode {
+        // recorded once per swapchain image, replayed every frame
+        Once,
+        // recorded again each frame, into a transient pool per frame in flight reset as a whole
+        PerFrame,
+        // recorded once into a secondary buffer that every image's primary executes; commands must not
+        // depend on the image, per-image data being fed by prologues (see "UniformBuffers" shared mode)
+        Shared
+    };
+
+    // "recordingThreads" enables "recordParallel()", each thread recording from its own pools
+    CommandPool(ImageViews* views, Mode mode = Mode::Once, uint32_t recordingThreads = 0) : DeviceBound(views), IRegenerable(views), _views(views), _mode(mode) {       
+        if(recordingThreads) _recorders = std::make_unique<ThreadPool>(recordingThreads);
+        _createCommandPools();
         _gen();
     }
 
     ~CommandPool() {
+        _destroyWorkerPools();
         vkDestroyCommandPool(*_device, _commandPool, nullptr);
+        for(auto pool : _framePools) {
+            vkDestroyCommandPool(*_device, pool, nullptr);
+        }
     }
 
+    // in "PerFrame" mode, commands are only called on next frames, so it is safe while the GPU is busy
     void record(RecordCallback commands) {
+        auto isRerecording = _isRecording();
         _recordedCommands = commands;
-        _sendCommands();
+        _recordedChunks = nullptr;
+        _onRecordChanged(isRerecording);
+    }
+
+    // called on each image's primary before its render pass begins, eg. to copy per-image data
+    void recordPrologue(PrologueCallback prologue) {
+        auto isRerecording = _isRecording();
+        _prologue = prologue;
+        _onRecordChanged(isRerecording);
+    }
+
+    // "commands" is called once per chunk, concurrently, each into a secondary buffer executed in chunks order.
+    // Viewport and scissor are already set on those.
+    void recordParallel(uint32_t chunksCount, ChunkRecordCallback commands) {
+        assert(_recorders && _mode != Mode::Shared);
+        auto isRerecording = _isRecording();
+        _recordedChunks = commands;
+        _chunksCount = chunksCount;
+        _recordedCommands = nullptr;
+        _onRecordChanged(isRerecording);
+    }
+
+    // "PerFrame" mode only : segments are executed in keys order, each from a secondary buffer cached per image,
+    // recorded again only once invalidated. Takes precedence over "record()" and "recordParallel()"
+    void setSegment(uint64_t key, RecordCallback commands) {
+        assert(_mode == Mode::PerFrame);
+        auto &segment = _segments[key];
+        segment.commands = commands;
+        segment.version++;
+    }
+
+    // inputs of the segment changed, its buffers will be recorded again when next used
+    void invalidateSegment(uint64_t key) {
+        auto found = _segments.find(key);
+        assert(found != _segments.end());
+        found->second.version++;
+    }
+
+    void removeSegment(uint64_t key) {
+        auto found = _segments.find(key);
+        if(found == _segments.end()) return;
+
+        // a pending frame might still execute them
+        for(size_t image = 0; image < found->second.perImage.size(); image++) {
+            auto buffer = found->second.perImage[image].buffer;
+            if(buffer != VK_NULL_HANDLE) _retiredSegmentBuffers(image).push_back(buffer);
+        }
+        _segments.erase(found);
+    }
+
+    struct SegmentStats {
+        uint64_t reused = 0;
+        uint64_t rerecorded = 0;
+    };
+
+    // since construction or "resetSegmentStats()"
+    const SegmentStats& segmentStats() const {
+        return _segmentStats;
+    }
+
+    void resetSegmentStats() {
+        _segmentStats = {};
+    }
+
+    // CPU time spent by the last recording, all images included in "Once" mode
+    std::chrono::nanoseconds lastRecordingTime() const {
+        return _lastRecordingTime;
+    }
+
+    Mode mode() const {
+        return _mode;
+    }
+
+    // times the render pass of each image's primary, slots being images. Record callbacks may nest their own scopes
+    // with "GpuProfiler::Zone(profiler(), cmdBuf, imageIndex, ...)", except from secondaries shared across images or cached
+    void profile(GpuProfiler* profiler) {
+        _profiler = profiler;
+        if(_isRecording()) _onRecordChanged(true);
+    }
+
+    GpuProfiler* profiler() const {
+        return _profiler;
+    }
+
+    // buffer to submit for this frame; records it first in "PerFrame" mode, which expects the frame's fence to be signaled
+    VkCommandBuffer commandBufferFor(size_t frameIndex, uint32_t imageIndex) {
+        if(_mode != Mode::PerFrame) return _commandBuffers[imageIndex];
+
+        //
+        auto result = vkResetCommandPool(*_device, _framePools[frameIndex], 0);
+        assert(result == VK_SUCCESS);
+
+        //
+        auto start = std::chrono::steady_clock::now();
+        auto commandBuffer = _frameCommandBuffers[frameIndex];
+        _recordInto(commandBuffer, frameIndex, imageIndex, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+        _lastRecordingTime = std::chrono::steady_clock::now() - start;
+        return commandBuffer;
     }
 
     const ImageViews* views() const {
@@ -58,81 +182,373 @@ class CommandPool : public DeviceBound, public IRegenerable {
     RecordCallback _recordedCommands;
     std::vector<VkCommandBuffer> _commandBuffers;
     const ImageViews* _views = nullptr;
+    Mode _mode;
+
+    std::array<VkCommandPool, MAX_FRAMES_IN_FLIGHT> _framePools{};
+    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> _frameCommandBuffers{};
+
+    // secondaries of a worker, handed out again once its pool is reset
+    struct WorkerPool {
+        VkCommandPool pool;
+        std::vector<VkCommandBuffer> buffers;
+        size_t used = 0;
+    };
+
+    std::unique_ptr<ThreadPool> _recorders;
+    ChunkRecordCallback _recordedChunks;
+    uint32_t _chunksCount = 0;
+    std::vector<std::vector<WorkerPool>> _workerPools; // per frame in flight or per image, then per worker
+    std::chrono::nanoseconds _lastRecordingTime{0};
+
+    PrologueCallback _prologue;
+    VkCommandBuffer _sharedCommands = VK_NULL_HANDLE;
+
+    GpuProfiler* _profiler = nullptr;
+
+    struct Segment {
+        struct Cached {
+            VkCommandBuffer buffer = VK_NULL_HANDLE;
+            uint64_t version = 0;
+        };
+
+        RecordCallback commands;
+        uint64_t version = 0; // recorded again whenever cached version differs
+        std::vector<Cached> perImage;
+    };
+
+    std::map<uint64_t, Segment> _segments;
+    std::vector<std::vector<VkCommandBuffer>> _retiredSegmentsBuffers; // per image, freed on its next recording
+    SegmentStats _segmentStats;
+
+    std::vector<VkCommandBuffer>& _retiredSegmentBuffers(size_t imageIndex) {
+        if(_retiredSegmentsBuffers.size() <= imageIndex) _retiredSegmentsBuffers.resize(imageIndex + 1);
+        return _retiredSegmentsBuffers[imageIndex];
+    }
+
+    static inline const std::array<VkClearValue, 1> _clearColors { VkClearValue{ {0.0f, 0.0f, 0.0f, 1.0f} } };
+
+    bool _isRecording() const {
+        return _recordedCommands || _recordedChunks || _prologue;
+    }
+
+    void _onRecordChanged(bool isRerecording) {
+        if(_mode == Mode::PerFrame) return;
+
+        // previous buffers might still be executing
+        if(isRerecording) vkDeviceWaitIdle(*_device);
+        _sendCommands();
+    }
 
     void _sendCommands() {
+        auto start = std::chrono::steady_clock::now();
+        if(_mode == Mode::Shared) _recordShared();
         for(size_t i = 0; i < _commandBuffers.size(); i++) {
+            _recordInto(_commandBuffers[i], i, i);
+        }
+        _lastRecordingTime = std::chrono::steady_clock::now() - start;
+    }
+
+    // "slot" is the frame in flight in "PerFrame" mode, the image otherwise
+    void _recordInto(VkCommandBuffer commandBuffer, size_t slot, size_t i, VkCommandBufferUsageFlags usage = 0) {
+        //
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = usage;
+        auto resultBegin = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        assert(resultBegin == VK_SUCCESS);
+
+        //
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = *_views->renderpass();
+        renderPassInfo.framebuffer = _views->framebuffer(i);
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = _views->renderpass()->target()->imageExtent;
+
+        renderPassInfo.clearValueCount = _clearColors.size();
+        renderPassInfo.pClearValues = _clearColors.data();
+
+        //
+        if(_profiler) _profiler->beginSlot(commandBuffer, i);
+        if(_prologue) _prologue(commandBuffer, i);
+
+        // pipeline statistics are left to nested scopes, which cannot be active while secondaries execute anyway
+        auto renderPassScope = _profiler ? _profiler->begin(commandBuffer, i, "render pass", false) : GpuProfiler::NO_SCOPE;
+
+        // secondaries first, as the render pass they continue must be begun with their contents only
+        if(_mode == Mode::Shared) {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(commandBuffer, 1, &_sharedCommands);
+            vkCmdEndRenderPass(commandBuffer);
+        } else if(!_segments.empty()) {
+            auto secondaries = _updateSegments(i);
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+            vkCmdEndRenderPass(commandBuffer);
+        } else if(_recordedChunks) {
+            auto secondaries = _recordChunks(slot, i, usage);
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(secondaries.size()), secondaries.data());
+            vkCmdEndRenderPass(commandBuffer);
+        } else {
+            _setDynamicStates(commandBuffer);
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+                //
+                if(_recordedCommands) _recordedCommands(commandBuffer, i);
+                //
+            vkCmdEndRenderPass(commandBuffer);
+        }
+
+        //
+        if(_profiler) _profiler->end(commandBuffer, i, renderPassScope);
+
+        //
+        auto resultEnd = vkEndCommandBuffer(commandBuffer);
+        assert(resultEnd == VK_SUCCESS);
+    }
+
+    // dynamic states are not inherited by secondaries, so each one sets them
+    void _setDynamicStates(VkCommandBuffer commandBuffer) {
+        auto viewport = _views->renderpass()->target()->defaultViewport();
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+        auto scissor = _views->renderpass()->target()->defaultScissor();
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    // any framebuffer of the render pass may execute it, and several primaries may be pending with it
+    void _recordShared() {
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = *_views->renderpass();
+        inheritance.subpass = 0;
+        inheritance.framebuffer = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+
+        //
+        auto resultBegin = vkBeginCommandBuffer(_sharedCommands, &beginInfo);
+        assert(resultBegin == VK_SUCCESS);
+
+            _setDynamicStates(_sharedCommands);
+            if(_recordedCommands) _recordedCommands(_sharedCommands, 0);
+
+        auto resultEnd = vkEndCommandBuffer(_sharedCommands);
+        assert(resultEnd == VK_SUCCESS);
+    }
+
+    // image's previous frame is done, so its cached segments may be recorded again
+    std::vector<VkCommandBuffer> _updateSegments(size_t imageIndex) {
+        auto &retired = _retiredSegmentBuffers(imageIndex);
+        if(!retired.empty()) {
+            vkFreeCommandBuffers(*_device, _commandPool, static_cast<uint32_t>(retired.size()), retired.data());
+            retired.clear();
+        }
+
+        //
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = *_views->renderpass();
+        inheritance.subpass = 0;
+        inheritance.framebuffer = VK_NULL_HANDLE;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+
+        //
+        std::vector<VkCommandBuffer> secondaries;
+        secondaries.reserve(_segments.size());
+        for(auto &[key, segment] : _segments) {
+            if(segment.perImage.size() <= imageIndex) segment.perImage.resize(imageIndex + 1);
+            auto &cached = segment.perImage[imageIndex];
+
+            // up to date
+            if(cached.buffer != VK_NULL_HANDLE && cached.version == segment.version) {
+                _segmentStats.reused++;
+                secondaries.push_back(cached.buffer);
+                continue;
+            }
+
             //
-            auto &commandBuffer = _commandBuffers[i];
-            
-            //
-            VkCommandBufferBeginInfo beginInfo{};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            auto resultBegin = vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            if(cached.buffer == VK_NULL_HANDLE) {
+                _allocateCommandBuffers(_commandPool, &cached.buffer, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            }
+
+            auto resultBegin = vkBeginCommandBuffer(cached.buffer, &beginInfo);
             assert(resultBegin == VK_SUCCESS);
 
+                _setDynamicStates(cached.buffer);
+                segment.commands(cached.buffer, imageIndex);
+
+            auto resultEnd = vkEndCommandBuffer(cached.buffer);
+            assert(resultEnd == VK_SUCCESS);
+
             //
-            VkRenderPassBeginInfo renderPassInfo{};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = *_views->renderpass();
-            renderPassInfo.framebuffer = _views->framebuffer(i);
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = _views->renderpass()->swapchain()->imageExtent;
+            cached.version = segment.version;
+            _segmentStats.rerecorded++;
+            secondaries.push_back(cached.buffer);
+        }
+
+        return secondaries;
+    }
 
-            const std::array<VkClearValue, 1> clearColors { {0.0f, 0.0f, 0.0f, 1.0f} };
-            renderPassInfo.clearValueCount = clearColors.size();
-            renderPassInfo.pClearValues = clearColors.data();
+    std::vector<VkCommandBuffer> _recordChunks(size_t slot, size_t imageIndex, VkCommandBufferUsageFlags usage) {
+        // previous secondaries of this slot are done with, as is the primary executing them
+        auto &workers = _workerPools[slot];
+        for(auto &worker : workers) {
+            auto result = vkResetCommandPool(*_device, worker.pool, 0);
+            assert(result == VK_SUCCESS);
+            worker.used = 0;
+        }
 
-            auto viewport = _views->renderpass()->swapchain()->defaultViewport();
-            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        //
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass = *_views->renderpass();
+        inheritance.subpass = 0;
+        inheritance.framebuffer = _views->framebuffer(imageIndex);
 
-            auto scissor = _views->renderpass()->swapchain()->defaultScissor();
-            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = usage | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
 
-                vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-                    //
-                    _recordedCommands(commandBuffer, i);
-                    //
-                vkCmdEndRenderPass(commandBuffer);
+        //
+        std::vector<VkCommandBuffer> secondaries(_chunksCount);
+        _recorders->parallelFor(_chunksCount, [&](uint32_t chunk, uint32_t workerIndex) {
+            auto &worker = workers[workerIndex];
+            if(worker.used == worker.buffers.size()) {
+                worker.buffers.push_back(VK_NULL_HANDLE);
+                _allocateCommandBuffers(worker.pool, &worker.buffers.back(), 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+            }
+            auto secondary = worker.buffers[worker.used++];
 
             //
-            auto resultEnd = vkEndCommandBuffer(commandBuffer);
+            auto resultBegin = vkBeginCommandBuffer(secondary, &beginInfo);
+            assert(resultBegin == VK_SUCCESS);
+
+                _setDynamicStates(secondary);
+                _recordedChunks(secondary, imageIndex, chunk);
+
+            auto resultEnd = vkEndCommandBuffer(secondary);
             assert(resultEnd == VK_SUCCESS);
-        }
+
+            //
+            secondaries[chunk] = secondary;
+        });
+
+        return secondaries;
     }
 
-    void _createCommandPool() {
+    VkCommandPool _createCommandPool(VkCommandPoolCreateFlags flags) {
         //
         VkCommandPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = _device->queueIndex();
-        poolInfo.flags = 0; // Optional
-        auto result = vkCreateCommandPool(*_device, &poolInfo, nullptr, &_commandPool);
+        poolInfo.flags = flags;
+
+        VkCommandPool pool;
+        auto result = vkCreateCommandPool(*_device, &poolInfo, nullptr, &pool);
         assert(result == VK_SUCCESS);
+        return pool;
     }
 
-    void _allocateCommandBuffers(int howMany) {
+    void _createCommandPools() {
+        // buffers are recorded again on "record()" calls, which implicitly resets them
+        _commandPool = _createCommandPool(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+
         //
-        _commandBuffers.resize(howMany);
+        if(_mode == Mode::Shared) {
+            _allocateCommandBuffers(_commandPool, &_sharedCommands, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        }
+        if(_mode != Mode::PerFrame) return;
+
+        // buffers are never freed individually, pools are reset instead
+        for(size_t i = 0; i < _framePools.size(); i++) {
+            _framePools[i] = _createCommandPool(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+            _allocateCommandBuffers(_framePools[i], &_frameCommandBuffers[i], 1);
+        }
+    }
+
+    void _createWorkerPools(size_t slotsCount) {
+        VkCommandPoolCreateFlags flags = _mode == Mode::PerFrame ? VK_COMMAND_POOL_CREATE_TRANSIENT_BIT : 0;
+        _workerPools.resize(slotsCount);
+        for(auto &workers : _workerPools) {
+            workers.resize(_recorders->workersCount());
+            for(auto &worker : workers) {
+                worker.pool = _createCommandPool(flags);
+            }
+        }
+    }
 
+    void _destroyWorkerPools() {
+        for(auto &workers : _workerPools) {
+            for(auto &worker : workers) {
+                vkDestroyCommandPool(*_device, worker.pool, nullptr);
+            }
+        }
+        _workerPools.clear();
+    }
+
+    void _allocateCommandBuffers(VkCommandPool pool, VkCommandBuffer* buffers, uint32_t howMany, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
         //
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.commandPool = _commandPool;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandBufferCount = (uint32_t) _commandBuffers.size();
+        allocInfo.commandPool = pool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = howMany;
 
         //
-        auto result = vkAllocateCommandBuffers(*_device, &allocInfo, _commandBuffers.data());
+        auto result = vkAllocateCommandBuffers(*_device, &allocInfo, buffers);
         assert(result == VK_SUCCESS);
     }
 
+    // per-frame buffers target whichever framebuffer is current when recorded, and need no regeneration
     void _gen() final {
-        _allocateCommandBuffers(_views->imagesCount());
-        if(_recordedCommands) _sendCommands();
+        // regeneration waited for the device to be idle, so retired and dropped buffers can be freed right away
+        std::vector<VkCommandBuffer> unused;
+        for(auto &retired : _retiredSegmentsBuffers) {
+            unused.insert(unused.end(), retired.begin(), retired.end());
+        }
+        _retiredSegmentsBuffers.clear();
+
+        // viewport, scissor and render pass they were recorded against changed; images beyond the new count are gone
+        auto imagesCount = _views->imagesCount();
+        for(auto &[key, segment] : _segments) {
+            segment.version++;
+            for(size_t image = imagesCount; image < segment.perImage.size(); image++) {
+                auto buffer = segment.perImage[image].buffer;
+                if(buffer != VK_NULL_HANDLE) unused.push_back(buffer);
+            }
+            if(segment.perImage.size() > imagesCount) segment.perImage.resize(imagesCount);
+        }
+        if(!unused.empty()) {
+            vkFreeCommandBuffers(*_device, _commandPool, static_cast<uint32_t>(unused.size()), unused.data());
+        }
+
+        //
+        if(_recorders) {
+            _createWorkerPools(_mode == Mode::PerFrame ? MAX_FRAMES_IN_FLIGHT : imagesCount);
+        }
+        if(_mode == Mode::PerFrame) return;
+
+        //
+        _commandBuffers.resize(imagesCount);
+        _allocateCommandBuffers(_commandPool, _commandBuffers.data(), static_cast<uint32_t>(_commandBuffers.size()));
+        if(_isRecording()) _sendCommands();
     }
 
     void _degen() final {
+        _destroyWorkerPools();
+        if(_commandBuffers.empty()) return;
         vkFreeCommandBuffers(*_device, _commandPool, static_cast<uint32_t>(_commandBuffers.size()), _commandBuffers.data());
+        _commandBuffers.clear();
     }
 };
 
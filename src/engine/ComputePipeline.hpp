@@ -0,0 +1,224 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Device.hpp"
+#include "helpers/ShaderFoundry.hpp"
+
+#include <array>
+#include <span>
+
+namespace Vulcain {
+
+// Compute shader with its storage buffers descriptor sets, one per slot (eg. per frame), all bound to set 0.
+// Not tied to the swapchain, so nothing to regenerate.
+class ComputePipeline : public DeviceBound {
+ public:
+    using WorkgroupSize = std::array<uint32_t, 3>;
+
+    ComputePipeline(const Device* device, const ShaderFoundry::Modules& modules, std::span<const VkDescriptorSetLayoutBinding> bindings, uint32_t pushConstantsSize, const WorkgroupSize& workgroupSize, size_t setsCount) :
+        DeviceBound(device),
+        _bindingsCount(static_cast<uint32_t>(bindings.size())),
+        _pushConstantsSize(pushConstantsSize),
+        _workgroupSize(workgroupSize) {
+        assert(modules.size() == 1 && modules[0].stage == VK_SHADER_STAGE_COMPUTE_BIT);
+        _createDescriptorSetLayout(bindings);
+        _createPipeline(modules[0]);
+        _createDescriptorSets(bindings, setsCount);
+    }
+
+    ~ComputePipeline() {
+        vkDestroyPipeline(*_device, _pipeline, nullptr);
+        vkDestroyPipelineLayout(*_device, _layout, nullptr);
+        vkDestroyDescriptorPool(*_device, _descriptorPool, nullptr);
+        vkDestroyDescriptorSetLayout(*_device, _descriptorSetLayout, nullptr);
+    }
+
+    operator VkPipeline() const { return _pipeline; }
+
+    VkPipelineLayout layout() const {
+        return _layout;
+    }
+
+    const WorkgroupSize& workgroupSize() const {
+        return _workgroupSize;
+    }
+
+    // whole buffers, in bindings order; set must not be in use by the GPU
+    void bindStorageBuffers(size_t set, std::span<const VkBuffer> buffers) {
+        assert(buffers.size() == _bindingsCount);
+
+        //
+        std::vector<VkDescriptorBufferInfo> buffersInfo(buffers.size());
+        std::vector<VkWriteDescriptorSet> writes(buffers.size());
+        for(size_t i = 0; i < buffers.size(); i++) {
+            buffersInfo[i].buffer = buffers[i];
+            buffersInfo[i].offset = 0;
+            buffersInfo[i].range = VK_WHOLE_SIZE;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = _descriptorSets[set];
+            writes[i].dstBinding = _bindings[i];
+            writes[i].dstArrayElement = 0;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].descriptorCount = 1;
+            writes[i].pBufferInfo = &buffersInfo[i];
+        }
+
+        vkUpdateDescriptorSets(*_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+
+    //
+    // Recording helpers, outside of any render pass
+    //
+
+    void bind(VkCommandBuffer cmdBuf, size_t set) const {
+        vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+        if(_descriptorSets.size()) {
+            vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_COMPUTE, _layout, 0, 1, &_descriptorSets[set], 0, nullptr);
+        }
+    }
+
+    template<class T>
+    void pushConstants(VkCommandBuffer cmdBuf, const T& constants) const {
+        assert(sizeof(T) <= _pushConstantsSize);
+        vkCmdPushConstants(cmdBuf, _layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(T), &constants);
+    }
+
+    // enough workgroups to cover "x * y * z" invocations, out of range ones being discarded by the shader
+    void dispatch(VkCommandBuffer cmdBuf, uint32_t x, uint32_t y = 1, uint32_t z = 1) const {
+        if(!x || !y || !z) return;
+        vkCmdDispatch(cmdBuf, _groupsCount(x, 0), _groupsCount(y, 1), _groupsCount(z, 2));
+    }
+
+    // makes writes of a dispatch visible to later commands
+    static void recordBufferBarrier(VkCommandBuffer cmdBuf, VkBuffer buffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+        auto barrier = bufferBarrier(buffer, srcAccess, dstAccess);
+        vkCmdPipelineBarrier(cmdBuf, srcStage, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    static VkBufferMemoryBarrier bufferBarrier(VkBuffer buffer, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        return barrier;
+    }
+
+ private:
+    const uint32_t _bindingsCount;
+    const uint32_t _pushConstantsSize;
+    const WorkgroupSize _workgroupSize;
+
+    VkDescriptorSetLayout _descriptorSetLayout;
+    VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+    VkPipelineLayout _layout;
+    VkPipeline _pipeline;
+    std::vector<uint32_t> _bindings;
+    std::vector<VkDescriptorSet> _descriptorSets;
+
+    uint32_t _groupsCount(uint32_t invocations, size_t axis) const {
+        auto size = std::max(_workgroupSize[axis], 1u);
+        return (invocations + size - 1) / size;
+    }
+
+    void _createDescriptorSetLayout(std::span<const VkDescriptorSetLayoutBinding> bindings) {
+        for(auto const &binding : bindings) {
+            _bindings.push_back(binding.binding);
+        }
+
+        //
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = _bindingsCount;
+        layoutInfo.pBindings = bindings.data();
+
+        auto result = vkCreateDescriptorSetLayout(*_device, &layoutInfo, nullptr, &_descriptorSetLayout);
+        assert(result == VK_SUCCESS);
+    }
+
+    void _createPipeline(const VkPipelineShaderStageCreateInfo& stage) {
+        //
+        VkPushConstantRange pushConstants{};
+        pushConstants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstants.offset = 0;
+        pushConstants.size = _pushConstantsSize;
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = _pushConstantsSize ? 1 : 0;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstants;
+
+        auto result = vkCreatePipelineLayout(*_device, &pipelineLayoutInfo, nullptr, &_layout);
+        assert(result == VK_SUCCESS);
+
+        //
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage = stage;
+        pipelineInfo.layout = _layout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+
+        result = vkCreateComputePipelines(*_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline);
+        assert(result == VK_SUCCESS);
+    }
+
+    void _createDescriptorSets(std::span<const VkDescriptorSetLayoutBinding> bindings, size_t setsCount) {
+        if(!setsCount || bindings.empty()) return;
+
+        //
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = static_cast<uint32_t>(setsCount * bindings.size());
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = static_cast<uint32_t>(setsCount);
+
+        auto result = vkCreateDescriptorPool(*_device, &poolInfo, nullptr, &_descriptorPool);
+        assert(result == VK_SUCCESS);
+
+        //
+        std::vector<VkDescriptorSetLayout> layouts(setsCount, _descriptorSetLayout);
+        _descriptorSets.resize(setsCount);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(setsCount);
+        allocInfo.pSetLayouts = layouts.data();
+
+        result = vkAllocateDescriptorSets(*_device, &allocInfo, _descriptorSets.data());
+        assert(result == VK_SUCCESS);
+    }
+};
+
+} // namespace Vulcain
@@ -0,0 +1,357 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Device.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <ostream>
+
+namespace Vulcain {
+
+// Records and submits per-frame compute work (culling, simulations, light binning...) ahead of graphics.
+// With a dedicated compute family, work goes to its own queue and graphics only waits for it from "waitStage" on,
+// so that compute of a frame runs while graphics of the previous one still does. Without, it is submitted along graphics on the main queue.
+// Resources written by compute then read by graphics must be shared across queues, eg. "IBuffer(..., shareAcrossQueues = true)".
+class ComputeScheduler : public DeviceBound {
+ public:
+    using RecordCallback = std::function<void(VkCommandBuffer, size_t frame)>;
+
+    // what graphics submission of a frame must include
+    struct Handoff {
+        VkSemaphore waitSemaphore = VK_NULL_HANDLE; // dedicated queue only
+        VkPipelineStageFlags waitStage = 0;
+        std::array<VkCommandBuffer, 2> beforeGraphics {};
+        uint32_t beforeGraphicsCount = 0;
+        VkCommandBuffer afterGraphics = VK_NULL_HANDLE;
+    };
+
+    // GPU time of frames, in milliseconds
+    struct Timings {
+        double compute = 0;
+        double graphics = 0;
+        double overlap = 0; // compute running while graphics was too
+    };
+
+    struct Report {
+        uint64_t frames = 0;
+        Timings total;
+
+        // share of compute hidden behind graphics
+        double overlapRatio() const {
+            return total.compute > 0 ? total.overlap / total.compute : 0;
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Report& report) {
+            auto frames = static_cast<double>(std::max<uint64_t>(report.frames, 1));
+            os << "frames: " << report.frames
+               << ", compute: " << report.total.compute / frames << " ms"
+               << ", graphics: " << report.total.graphics / frames << " ms"
+               << ", overlap: " << report.total.overlap / frames << " ms"
+               << " (" << report.overlapRatio() * 100 << "% of compute)";
+            return os;
+        }
+    };
+
+    // "waitStage" is the first graphics stage consuming compute results
+    ComputeScheduler(const Device* device, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT) : 
+        DeviceBound(device),
+        _waitStage(waitStage),
+        _isAsync(device->hasDedicatedComputeQueue()),
+        _isTimed(device->timestampValidBits(device->computeQueueIndex()) && device->timestampValidBits(device->queueIndex())),
+        _timestampPeriod(device->properties().limits.timestampPeriod) {
+        _computePool = _createCommandPool(_device->computeQueueIndex(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+        _graphicsPool = _createCommandPool(_device->queueIndex(), 0);
+        _allocateCommandBuffers(_computePool, _computeCmds.data(), MAX_FRAMES_IN_FLIGHT);
+        _allocateCommandBuffers(_graphicsPool, _graphicsBeginCmds.data(), MAX_FRAMES_IN_FLIGHT);
+        _allocateCommandBuffers(_graphicsPool, _graphicsEndCmds.data(), MAX_FRAMES_IN_FLIGHT);
+
+        //
+        _createSyncObjects();
+        if(_isTimed) _createQueryPool();
+        _recordGraphicsTimestamps();
+    }
+
+    ~ComputeScheduler() {
+        vkDeviceWaitIdle(*_device);
+
+        //
+        for(auto semaphore : _computeFinished) {
+            vkDestroySemaphore(*_device, semaphore, nullptr);
+        }
+        vkDestroyQueryPool(*_device, _queryPool, nullptr);
+        vkDestroyCommandPool(*_device, _graphicsPool, nullptr);
+        vkDestroyCommandPool(*_device, _computePool, nullptr);
+    }
+
+    // called once per frame, compute queue commands only (no graphics stages)
+    void record(RecordCallback callback) {
+        _record = callback;
+    }
+
+    // compute work runs on its own queue
+    bool isAsync() const {
+        return _isAsync;
+    }
+
+    // records and submits compute work of "frame", whose previous submission must be complete (eg. its fence waited)
+    Handoff submit(size_t frame) {
+        if(_isTimed) _readTimestamps(frame);
+
+        //
+        auto cmdBuf = _computeCmds[frame];
+        vkResetCommandBuffer(cmdBuf, 0);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        auto result = vkBeginCommandBuffer(cmdBuf, &beginInfo);
+        assert(result == VK_SUCCESS);
+
+            //
+            if(_isTimed) {
+                vkCmdResetQueryPool(cmdBuf, _queryPool, _query(frame, COMPUTE_BEGIN), 2);
+                vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool, _query(frame, COMPUTE_BEGIN));
+            }
+
+            //
+            if(_record) _record(cmdBuf, frame);
+
+            //
+            if(_isTimed) {
+                vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, _query(frame, COMPUTE_END));
+            }
+
+            // same queue : a barrier stands for the semaphore
+            if(!_isAsync) {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+                vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, _waitStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            }
+
+        result = vkEndCommandBuffer(cmdBuf);
+        assert(result == VK_SUCCESS);
+
+        //
+        _submitted[frame] = true;
+
+        //
+        Handoff handoff;
+        handoff.afterGraphics = _graphicsEndCmds[frame];
+
+        // recorded work precedes graphics in the same submission
+        if(!_isAsync) {
+            handoff.beforeGraphics = { cmdBuf, _graphicsBeginCmds[frame] };
+            handoff.beforeGraphicsCount = 2;
+            return handoff;
+        }
+
+        //
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuf;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &_computeFinished[frame];
+
+        result = vkQueueSubmit(_device->computeQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+        assert(result == VK_SUCCESS);
+
+        //
+        handoff.waitSemaphore = _computeFinished[frame];
+        handoff.waitStage = _waitStage;
+        handoff.beforeGraphics = { _graphicsBeginCmds[frame] };
+        handoff.beforeGraphicsCount = 1;
+        return handoff;
+    }
+
+    // timings of the most recently completed frame
+    const Timings& lastTimings() const {
+        return _lastTimings;
+    }
+
+    // accumulated since construction or last reset; empty if a queue family cannot write timestamps.
+    // Compute and graphics timestamps come from different queues, which share a timebase on most implementations but not per spec
+    const Report& report() const {
+        return _report;
+    }
+
+    void resetReport() {
+        _report = {};
+    }
+
+ private:
+    enum Query : uint32_t {
+        COMPUTE_BEGIN,
+        COMPUTE_END,
+        GRAPHICS_BEGIN,
+        GRAPHICS_END,
+        QUERIES_PER_FRAME
+    };
+
+    const VkPipelineStageFlags _waitStage;
+    const bool _isAsync;
+    const bool _isTimed;
+    const float _timestampPeriod;
+
+    VkCommandPool _computePool;
+    VkCommandPool _graphicsPool;
+    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> _computeCmds;
+    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> _graphicsBeginCmds;
+    std::array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> _graphicsEndCmds;
+    std::array<VkSemaphore, MAX_FRAMES_IN_FLIGHT> _computeFinished;
+    std::array<bool, MAX_FRAMES_IN_FLIGHT> _submitted {};
+    VkQueryPool _queryPool = VK_NULL_HANDLE;
+
+    RecordCallback _record;
+
+    // graphics span of the previously read frame, whose tail compute of the next frame may overlap
+    uint64_t _previousGraphicsBegin = 0;
+    uint64_t _previousGraphicsEnd = 0;
+    Timings _lastTimings;
+    Report _report;
+
+    static uint32_t _query(size_t frame, Query query) {
+        return static_cast<uint32_t>(frame) * QUERIES_PER_FRAME + query;
+    }
+
+    double _toMs(uint64_t ticks) const {
+        return static_cast<double>(ticks) * _timestampPeriod / 1e6;
+    }
+
+    static uint64_t _intersection(uint64_t aBegin, uint64_t aEnd, uint64_t bBegin, uint64_t bEnd) {
+        auto begin = std::max(aBegin, bBegin);
+        auto end = std::min(aEnd, bEnd);
+        return end > begin ? end - begin : 0;
+    }
+
+    // results are available without waiting, since the frame's previous submission is complete
+    void _readTimestamps(size_t frame) {
+        if(!_submitted[frame]) return;
+
+        //
+        std::array<uint64_t, QUERIES_PER_FRAME> ticks;
+        auto result = vkGetQueryPoolResults(
+            *_device, _queryPool, 
+            _query(frame, COMPUTE_BEGIN), QUERIES_PER_FRAME, 
+            sizeof(ticks), ticks.data(), sizeof(uint64_t), 
+            VK_QUERY_RESULT_64_BIT
+        );
+        if(result != VK_SUCCESS) return;
+
+        //
+        auto computeBegin = ticks[COMPUTE_BEGIN], computeEnd = ticks[COMPUTE_END];
+        auto graphicsBegin = ticks[GRAPHICS_BEGIN], graphicsEnd = ticks[GRAPHICS_END];
+        auto overlap = _intersection(computeBegin, computeEnd, _previousGraphicsBegin, _previousGraphicsEnd)
+                     + _intersection(computeBegin, computeEnd, graphicsBegin, graphicsEnd);
+
+        //
+        _lastTimings.compute = _toMs(computeEnd - computeBegin);
+        _lastTimings.graphics = _toMs(graphicsEnd - graphicsBegin);
+        _lastTimings.overlap = _toMs(overlap);
+
+        _report.frames++;
+        _report.total.compute += _lastTimings.compute;
+        _report.total.graphics += _lastTimings.graphics;
+        _report.total.overlap += _lastTimings.overlap;
+
+        //
+        _previousGraphicsBegin = graphicsBegin;
+        _previousGraphicsEnd = graphicsEnd;
+    }
+
+    // graphics queries are reset from the graphics queue, since its begin timestamp is not ordered after the compute semaphore
+    void _recordGraphicsTimestamps() {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        for(size_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+            //
+            auto result = vkBeginCommandBuffer(_graphicsBeginCmds[frame], &beginInfo);
+            assert(result == VK_SUCCESS);
+                if(_isTimed) {
+                    vkCmdResetQueryPool(_graphicsBeginCmds[frame], _queryPool, _query(frame, GRAPHICS_BEGIN), 2);
+                    vkCmdWriteTimestamp(_graphicsBeginCmds[frame], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool, _query(frame, GRAPHICS_BEGIN));
+                }
+            result = vkEndCommandBuffer(_graphicsBeginCmds[frame]);
+            assert(result == VK_SUCCESS);
+
+            //
+            result = vkBeginCommandBuffer(_graphicsEndCmds[frame], &beginInfo);
+            assert(result == VK_SUCCESS);
+                if(_isTimed) {
+                    vkCmdWriteTimestamp(_graphicsEndCmds[frame], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, _query(frame, GRAPHICS_END));
+                }
+            result = vkEndCommandBuffer(_graphicsEndCmds[frame]);
+            assert(result == VK_SUCCESS);
+        }
+    }
+
+    VkCommandPool _createCommandPool(int family, VkCommandPoolCreateFlags flags) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = static_cast<uint32_t>(family);
+        poolInfo.flags = flags;
+
+        VkCommandPool pool;
+        auto result = vkCreateCommandPool(*_device, &poolInfo, nullptr, &pool);
+        assert(result == VK_SUCCESS);
+        return pool;
+    }
+
+    void _allocateCommandBuffers(VkCommandPool pool, VkCommandBuffer* buffers, uint32_t howMany) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = howMany;
+
+        auto result = vkAllocateCommandBuffers(*_device, &allocInfo, buffers);
+        assert(result == VK_SUCCESS);
+    }
+
+    void _createSyncObjects() {
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        for(auto &semaphore : _computeFinished) {
+            auto result = vkCreateSemaphore(*_device, &semaphoreInfo, nullptr, &semaphore);
+            assert(result == VK_SUCCESS);
+        }
+    }
+
+    void _createQueryPool() {
+        VkQueryPoolCreateInfo queryPoolInfo{};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = MAX_FRAMES_IN_FLIGHT * QUERIES_PER_FRAME;
+
+        auto result = vkCreateQueryPool(*_device, &queryPoolInfo, nullptr, &_queryPool);
+        assert(result == VK_SUCCESS);
+    }
+};
+
+} // namespace Vulcain
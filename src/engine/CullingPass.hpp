@@ -0,0 +1,184 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "buffers/IBuffer.hpp"
+#include "helpers/PipelineFactory.hpp"
+#include "helpers/Frustum.hpp"
+
+#include "cull.hpp"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <span>
+
+namespace Vulcain {
+
+// matches "CulledObject" of cull.comp (std430)
+struct CulledObject {
+    glm::mat4 model;
+    glm::vec4 boundingSphere; // model space center, radius
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    uint32_t instanceIndex = 0; // firstInstance of its draw, eg. to fetch per-object data in vertex shaders; 0 if "drawIndirectFirstInstance" is not supported
+};
+static_assert(sizeof(CulledObject) == 96);
+
+// GPU driven draws : "cull.comp" tests objects against the frustum and writes the draw commands of survivors,
+// consumed by "recordDraws()" without the CPU ever looking at objects. 
+// "recordCulling()" goes in a "CommandPool" prologue, outside the render pass, or in a "ComputeScheduler" callback; "recordDraws()" inside the render pass,
+// once pipeline and geometry (eg. a "GeometryHeap") are bound. Each slot (frame or image) has its own buffers, shared across queues.
+class CullingPass : public DeviceBound {
+ public:
+    CullingPass(const Device* device, PipelineFactory* factory, size_t slotsCount, uint32_t maxObjects) : 
+        DeviceBound(device), 
+        _maxObjects(maxObjects),
+        _usesDrawCount(device->hasExtension(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME)),
+        _pipeline(factory->createCompute<Pipelines::cull>(slotsCount)) {
+        //
+        if(_usesDrawCount) {
+            _drawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(*_device, "vkCmdDrawIndexedIndirectCountKHR")
+            );
+            assert(_drawIndexedIndirectCount);
+        }
+
+        //
+        _createSlots(slotsCount);
+    }
+
+    // compacted commands and a GPU written draw count if supported, one command per object otherwise
+    bool usesDrawCount() const {
+        return _usesDrawCount;
+    }
+
+    // slot must not be in use by the GPU anymore
+    void updateObjects(size_t slot, std::span<const CulledObject> objects) {
+        assert(objects.size() <= _maxObjects);
+        auto &s = *_slots[slot];
+        memcpy(s.objects.mappedData(), objects.data(), objects.size_bytes());
+        s.objectCount = static_cast<uint32_t>(objects.size());
+    }
+
+    void recordCulling(VkCommandBuffer cmdBuf, size_t slot, const Frustum& frustum) const {
+        auto &s = *_slots[slot];
+
+        // reset count, which previous draws were reading
+        if(_usesDrawCount) {
+            auto toTransfer = ComputePipeline::bufferBarrier(s.count.buffer, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+            vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &toTransfer, 0, nullptr);
+            vkCmdFillBuffer(cmdBuf, s.count.buffer, 0, sizeof(uint32_t), 0);
+        }
+
+        // previous draws are done reading commands, and count is reset
+        std::array<VkBufferMemoryBarrier, 2> toCompute {
+            ComputePipeline::bufferBarrier(s.commands.buffer, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT),
+            ComputePipeline::bufferBarrier(s.count.buffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT)
+        };
+        vkCmdPipelineBarrier(cmdBuf, 
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 
+            0, 0, nullptr, _usesDrawCount ? 2 : 1, toCompute.data(), 0, nullptr
+        );
+
+        //
+        PushConstants constants;
+        constants.planes = frustum.planes;
+        constants.objectCount = s.objectCount;
+        constants.compact = _usesDrawCount;
+        constants.firstInstance = _device->features().drawIndirectFirstInstance;
+
+        _pipeline.bind(cmdBuf, slot);
+        _pipeline.pushConstants(cmdBuf, constants);
+        _pipeline.dispatch(cmdBuf, s.objectCount);
+
+        // commands and count are ready to be drawn
+        std::array<VkBufferMemoryBarrier, 2> toIndirect {
+            ComputePipeline::bufferBarrier(s.commands.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT),
+            ComputePipeline::bufferBarrier(s.count.buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT)
+        };
+        vkCmdPipelineBarrier(cmdBuf, 
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 
+            0, 0, nullptr, _usesDrawCount ? 2 : 1, toIndirect.data(), 0, nullptr
+        );
+    }
+
+    void recordDraws(VkCommandBuffer cmdBuf, size_t slot) const {
+        auto &s = *_slots[slot];
+        if(!s.objectCount) return;
+
+        //
+        constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        if(_usesDrawCount) {
+            _drawIndexedIndirectCount(cmdBuf, s.commands.buffer, 0, s.count.buffer, 0, s.objectCount, stride);
+        } else if(_device->features().multiDrawIndirect) {
+            vkCmdDrawIndexedIndirect(cmdBuf, s.commands.buffer, 0, s.objectCount, stride);
+        } else {
+            // culled objects still cost a draw, of no instance
+            for(uint32_t i = 0; i < s.objectCount; i++) {
+                vkCmdDrawIndexedIndirect(cmdBuf, s.commands.buffer, i * stride, 1, stride);
+            }
+        }
+    }
+
+ private:
+    // matches "Culling" push constants of cull.comp
+    struct PushConstants {
+        std::array<glm::vec4, 6> planes;
+        uint32_t objectCount;
+        uint32_t compact;
+        uint32_t firstInstance;
+    };
+    static_assert(sizeof(PushConstants) == Pipelines::cull::pushConstantsSize);
+
+    struct Slot {
+        IBuffer objects;
+        IBuffer commands;
+        IBuffer count;
+        uint32_t objectCount = 0;
+    };
+
+    const uint32_t _maxObjects;
+    const bool _usesDrawCount;
+    PFN_vkCmdDrawIndexedIndirectCountKHR _drawIndexedIndirectCount = nullptr;
+
+    ComputePipeline _pipeline;
+    std::vector<std::unique_ptr<Slot>> _slots;
+
+    void _createSlots(size_t slotsCount) {
+        //
+        for(size_t i = 0; i < slotsCount; i++) {
+            auto &slot = _slots.emplace_back(new Slot {
+                IBuffer(this, sizeof(CulledObject) * _maxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VMA_ALLOCATION_CREATE_MAPPED_BIT, true),
+                IBuffer(this, sizeof(VkDrawIndexedIndirectCommand) * _maxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, 0, true),
+                IBuffer(this, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, 0, true)
+            });
+
+            //
+            std::array<VkBuffer, 3> buffers { slot->objects.buffer, slot->commands.buffer, slot->count.buffer };
+            _pipeline.bindStorageBuffers(i, buffers);
+        }
+    }
+};
+
+} // namespace Vulcain
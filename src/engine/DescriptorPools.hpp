@@ -19,13 +19,13 @@
 
 #pragma once
 
-#include "Swapchain.hpp"
+#include "IRenderTarget.hpp"
 
 namespace Vulcain {
 
 class DescriptorPools : public DeviceBound, public IRegenerable {
  public:
-    DescriptorPools(Swapchain* swapchain) : DeviceBound(swapchain), IRegenerable(swapchain), _swapchain(swapchain) {}
+    DescriptorPools(IRenderTarget* target) : DeviceBound(target), IRegenerable(target), _target(target) {}
 
     // might create specialized pool if needed
     VkDescriptorPool pool(VkDescriptorType type) {
@@ -42,18 +42,18 @@ class DescriptorPools : public DeviceBound, public IRegenerable {
         _degen();
     }
 
-    const Swapchain* swapchain() const {
-        return _swapchain;
+    const IRenderTarget* target() const {
+        return _target;
     }
 
  private:
-    const Swapchain* _swapchain = nullptr;
+    const IRenderTarget* _target = nullptr;
     std::map<VkDescriptorType, VkDescriptorPool> _descriptorPools;
 
     void _createDescrPool(VkDescriptorType type) {
         VkDescriptorPoolSize poolSize{};
         poolSize.type = type;
-        poolSize.descriptorCount = static_cast<uint32_t>(_swapchain->imagesCount());
+        poolSize.descriptorCount = static_cast<uint32_t>(_target->imagesCount());
 
         VkDescriptorPoolCreateInfo poolInfo{};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
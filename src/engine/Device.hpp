@@ -21,23 +21,38 @@
 
 #include "common/Vulcain.h"
 
+#include <vk_mem_alloc.h>
+
 #include "helpers/DeviceDetails.hpp"
 
+#include <algorithm>
+#include <string.h>
+
 namespace Vulcain {
 
 class Device {
  public:
+    // presenting devices only, headless ones requiring none
     static inline const std::array<const char*, 1> REQUIRED_DEVICE_EXTENSIONS {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
 
+    // enabled only if the physical device supports them, see "hasExtension()"
+    static inline const std::array<const char*, 3> OPTIONAL_DEVICE_EXTENSIONS {
+        VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,
+        VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+        VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME
+    };
+
     Device(const PhysicalDeviceDetails* pDeviceDetails) : _pDeviceDetails(pDeviceDetails) {
         _instaciateLogicalDevice();
+        _createAllocator();
     }
 
     operator VkDevice() const { return _device; }
 
     ~Device() {
+        vmaDestroyAllocator(_allocator);
         vkDestroyDevice(_device, nullptr);
     }
 
@@ -53,14 +68,79 @@ class Device {
         return _presentationAndGraphicsQueue;
     }
 
+    // dedicated transfer family if any, main queue family otherwise
+    int transferQueueIndex() const {
+        return hasDedicatedTransferQueue() ? _pDeviceDetails->transferQueueIndex : queueIndex();
+    }
+
+    VkQueue transferQueue() const {
+        return _transferQueue;
+    }
+
+    bool hasDedicatedTransferQueue() const {
+        return _pDeviceDetails->transferQueueIndex >= 0;
+    }
+
+    // dedicated compute family if any, main queue family otherwise
+    int computeQueueIndex() const {
+        return hasDedicatedComputeQueue() ? _pDeviceDetails->computeQueueIndex : queueIndex();
+    }
+
+    VkQueue computeQueue() const {
+        return _computeQueue;
+    }
+
+    bool hasDedicatedComputeQueue() const {
+        return _pDeviceDetails->computeQueueIndex >= 0;
+    }
+
+    // unique families queues were created from, as expected by VK_SHARING_MODE_CONCURRENT resources
+    const std::vector<uint32_t>& queueFamilies() const {
+        return _queueFamilies;
+    }
+
     const SwapChainSupportDetails& swapchainDetails() const {
         return _pDeviceDetails->swapchainDetails;
     }
 
+    // null if headless
     const Surface* surface() const {
         return _pDeviceDetails->surface;
     }
 
+    const Instance* instance() const {
+        return _pDeviceDetails->instance;
+    }
+
+    const VkPhysicalDeviceProperties& properties() const {
+        return _pDeviceDetails->properties;
+    }
+
+    // 0 if the family cannot write timestamps
+    uint32_t timestampValidBits(int family) const {
+        uint32_t count;
+        vkGetPhysicalDeviceQueueFamilyProperties(_pDeviceDetails->pDevice, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> families(count);
+        vkGetPhysicalDeviceQueueFamilyProperties(_pDeviceDetails->pDevice, &count, families.data());
+        return families[family].timestampValidBits;
+    }
+
+    bool hasExtension(const char* name) const {
+        return std::any_of(_enabledExtensions.begin(), _enabledExtensions.end(), [name](const char* enabled) {
+            return strcmp(enabled, name) == 0;
+        });
+    }
+
+    // optional features turned on when supported
+    const VkPhysicalDeviceFeatures& features() const {
+        return _features;
+    }
+
+    // sub-allocates every buffer of this device from shared memory blocks
+    VmaAllocator allocator() const {
+        return _allocator;
+    }
+
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
         VkPhysicalDeviceMemoryProperties memProperties;
         vkGetPhysicalDeviceMemoryProperties(_pDeviceDetails->pDevice, &memProperties);
@@ -79,40 +159,65 @@ class Device {
 
     VkDevice _device;
     VkQueue _presentationAndGraphicsQueue;
+    VkQueue _transferQueue;
+    VkQueue _computeQueue;
+    std::vector<uint32_t> _queueFamilies;
+    std::vector<const char*> _enabledExtensions;
+    VkPhysicalDeviceFeatures _features{};
+    VmaAllocator _allocator;
 
     float _queuePriority = 1.f;
     
     void _instaciateLogicalDevice() {
-        // instanciate main queue
-        VkDeviceQueueCreateInfo queueCreateInfo{};
-        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queueCreateInfo.queueFamilyIndex = _pDeviceDetails->presentationAndGraphicsQueueIndex;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &_queuePriority;
+        // main queue first, then dedicated ones if any
+        for(auto family : { queueIndex(), transferQueueIndex(), computeQueueIndex() }) {
+            auto asUnsigned = static_cast<uint32_t>(family);
+            if(std::find(_queueFamilies.begin(), _queueFamilies.end(), asUnsigned) != _queueFamilies.end()) continue;
+            _queueFamilies.push_back(asUnsigned);
+        }
+
+        // instanciate a queue per family
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+        for(auto family : _queueFamilies) {
+            auto &queueCreateInfo = queueCreateInfos.emplace_back();
+            queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueCreateInfo.queueFamilyIndex = family;
+            queueCreateInfo.queueCount = 1;
+            queueCreateInfo.pQueuePriorities = &_queuePriority;
+        }
 
         //
-        VkPhysicalDeviceFeatures deviceFeatures{};
+        _pickExtensions();
+        _pickFeatures();
 
         // create infos
         VkDeviceCreateInfo deviceCreateInfo{};
         deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 
             //
-            deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
-            deviceCreateInfo.queueCreateInfoCount = 1;
+            deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
+            deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 
             //
-            deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+            deviceCreateInfo.pEnabledFeatures = &_features;
+
+            // mandatory once the extension is supported
+            VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures{};
+            timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+            timelineFeatures.timelineSemaphore = VK_TRUE;
+            if(hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+                deviceCreateInfo.pNext = &timelineFeatures;
+            }
 
             //
-            if(auto createInfo = surface()->instance()->createInfo(); createInfo->enabledLayerCount) {
+            if(auto createInfo = instance()->createInfo(); createInfo->enabledLayerCount) {
                 deviceCreateInfo.enabledLayerCount = createInfo->enabledLayerCount;
                 deviceCreateInfo.ppEnabledLayerNames = createInfo->ppEnabledLayerNames;
             }
             
             //
-            deviceCreateInfo.enabledExtensionCount = REQUIRED_DEVICE_EXTENSIONS.size();
-            deviceCreateInfo.ppEnabledExtensionNames = REQUIRED_DEVICE_EXTENSIONS.data();
+            deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(_enabledExtensions.size());
+            deviceCreateInfo.ppEnabledExtensionNames = _enabledExtensions.data();
 
         // create device
         auto result = vkCreateDevice(
@@ -128,8 +233,77 @@ class Device {
         volkLoadDevice(_device);
         #endif
 
-        // get main queue
-        vkGetDeviceQueue(_device, _pDeviceDetails->presentationAndGraphicsQueueIndex, 0, &_presentationAndGraphicsQueue);
+        // get queues, which alias the main one if no dedicated family exists
+        vkGetDeviceQueue(_device, queueIndex(), 0, &_presentationAndGraphicsQueue);
+        vkGetDeviceQueue(_device, transferQueueIndex(), 0, &_transferQueue);
+        vkGetDeviceQueue(_device, computeQueueIndex(), 0, &_computeQueue);
+    }
+
+    void _pickExtensions() {
+        uint32_t count;
+        vkEnumerateDeviceExtensionProperties(_pDeviceDetails->pDevice, nullptr, &count, nullptr);
+        std::vector<VkExtensionProperties> available(count);
+        vkEnumerateDeviceExtensionProperties(_pDeviceDetails->pDevice, nullptr, &count, available.data());
+
+        //
+        if(surface()) _enabledExtensions.assign(REQUIRED_DEVICE_EXTENSIONS.begin(), REQUIRED_DEVICE_EXTENSIONS.end());
+        for(auto optional : OPTIONAL_DEVICE_EXTENSIONS) {
+            // depends on an instance extension on Vulkan 1.0
+            auto isTimeline = strcmp(optional, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+            if(isTimeline && !instance()->createInfo()->hasExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) continue;
+
+            // depends on the swapchain extension
+            auto isDisplayTiming = strcmp(optional, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME) == 0;
+            if(isDisplayTiming && !surface()) continue;
+
+            //
+            auto isAvailable = std::any_of(available.begin(), available.end(), [optional](const VkExtensionProperties& properties) {
+                return strcmp(properties.extensionName, optional) == 0;
+            });
+            if(isAvailable) _enabledExtensions.push_back(optional);
+        }
+    }
+
+    // indirect draws of many objects at once, each with its own first instance, and profiling of shader invocations
+    void _pickFeatures() {
+        VkPhysicalDeviceFeatures supported;
+        vkGetPhysicalDeviceFeatures(_pDeviceDetails->pDevice, &supported);
+        _features.multiDrawIndirect = supported.multiDrawIndirect;
+        _features.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+        _features.pipelineStatisticsQuery = supported.pipelineStatisticsQuery;
+    }
+
+    void _createAllocator() {
+        // feed VMA with already loaded entry points, either from volk or the standard loader
+        VmaVulkanFunctions functions{};
+        functions.vkGetPhysicalDeviceProperties = vkGetPhysicalDeviceProperties;
+        functions.vkGetPhysicalDeviceMemoryProperties = vkGetPhysicalDeviceMemoryProperties;
+        functions.vkAllocateMemory = vkAllocateMemory;
+        functions.vkFreeMemory = vkFreeMemory;
+        functions.vkMapMemory = vkMapMemory;
+        functions.vkUnmapMemory = vkUnmapMemory;
+        functions.vkFlushMappedMemoryRanges = vkFlushMappedMemoryRanges;
+        functions.vkInvalidateMappedMemoryRanges = vkInvalidateMappedMemoryRanges;
+        functions.vkBindBufferMemory = vkBindBufferMemory;
+        functions.vkBindImageMemory = vkBindImageMemory;
+        functions.vkGetBufferMemoryRequirements = vkGetBufferMemoryRequirements;
+        functions.vkGetImageMemoryRequirements = vkGetImageMemoryRequirements;
+        functions.vkCreateBuffer = vkCreateBuffer;
+        functions.vkDestroyBuffer = vkDestroyBuffer;
+        functions.vkCreateImage = vkCreateImage;
+        functions.vkDestroyImage = vkDestroyImage;
+        functions.vkCmdCopyBuffer = vkCmdCopyBuffer;
+
+        //
+        VmaAllocatorCreateInfo allocatorInfo{};
+        allocatorInfo.physicalDevice = _pDeviceDetails->pDevice;
+        allocatorInfo.device = _device;
+        allocatorInfo.instance = *instance();
+        allocatorInfo.pVulkanFunctions = &functions;
+
+        //
+        auto result = vmaCreateAllocator(&allocatorInfo, &_allocator);
+        assert(result == VK_SUCCESS);
     }
 };
 
@@ -0,0 +1,287 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Pipeline.hpp"
+
+#include "buffers/DynamicBuffer.hpp"
+#include "buffers/GeometryHeap.hpp"
+#include "buffers/StaticBuffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <numeric>
+#include <span>
+#include <tuple>
+
+namespace Vulcain {
+
+// Collects draws for a command buffer, then records them sorted by state and merged into instanced draws.
+// Per-instance data, if any, is fed to "VertexLayout::INSTANCE_BINDING", each slot (frame or image) owning its instance buffer.
+class DrawList : public DeviceBound {
+ public:
+    // what vkCmdDrawIndexed needs, with the buffers to bind
+    struct Geometry {
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+
+        template<class V>
+        static Geometry of(const GeometryHeap<V>& heap, const typename GeometryHeap<V>::Mesh& mesh) {
+            return { heap.vertexBuffer(), heap.indexBuffer(), GeometryHeap<V>::INDEX_TYPE, mesh.firstIndex, mesh.indexCount, mesh.vertexOffset };
+        }
+
+        template<class V, class I>
+        static Geometry of(const StaticBuffer<V>& vertices, const TStaticIndexBuffer<I>& indices) {
+            return { vertices.buffer, indices.buffer, indexTypeOf<I>(), 0, indices.vertexCount(), 0 };
+        }
+    };
+
+    // descriptor set bound at set 0, with its dynamic offset if the pipeline uses dynamic uniforms
+    struct Material {
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        std::optional<uint32_t> dynamicOffset;
+    };
+
+    struct Stats {
+        uint32_t pipelineBinds = 0;
+        uint32_t descriptorBinds = 0;
+        uint32_t geometryBinds = 0;
+        uint32_t draws = 0;
+        uint32_t instances = 0;
+    };
+
+    // "instanceStride" is the size of per-instance data, 0 if none; pipelines drawn then read it as "I" of "PipelineFactory::create<V, I>()"
+    DrawList(const DeviceBound* deviceBound, size_t slotsCount, uint32_t instanceStride = 0) : 
+        DeviceBound(deviceBound), 
+        _instanceStride(instanceStride), 
+        _instances(this, slotsCount, std::max<uint32_t>(1, instanceStride) * 64) {}
+
+    // "instanceData" must be "instanceStride" long
+    void add(const Pipeline* pipeline, const Geometry& geometry, const Material& material, std::span<const std::byte> instanceData = {}) {
+        assert(instanceData.size() == _instanceStride);
+
+        //
+        Item item;
+        item.pipeline = pipeline;
+        item.geometry = geometry;
+        item.material = material;
+        item.key = _key(pipeline, geometry, material);
+        item.instanceOffset = static_cast<uint32_t>(_instanceData.size());
+        _items.push_back(item);
+
+        //
+        _instanceData.insert(_instanceData.end(), instanceData.begin(), instanceData.end());
+    }
+
+    void clear() {
+        _items.clear();
+        _order.clear();
+        _instanceData.clear();
+        _pipelineIds.clear();
+        _materialIds.clear();
+        _buffersIds.clear();
+        _geometryIds.clear();
+    }
+
+    auto size() const {
+        return _items.size();
+    }
+
+    // "slot" must not be in use by the GPU anymore. Returns true if the slot's instance buffer grew,
+    // in which case commands recorded earlier for this slot are invalid
+    bool record(VkCommandBuffer cmdBuf, size_t slot) {
+        // as submitted, with only redundant binds skipped
+        _before = _simulate(_items);
+
+        // items are kept in submission order, so that recording the list again gives the same "before" stats
+        _order.resize(_items.size());
+        std::iota(_order.begin(), _order.end(), 0);
+        std::stable_sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b) {
+            return _items[a].key < _items[b].key;
+        });
+
+        // instances of a batch must be contiguous, so instance data follows sorted order
+        bool grew = false;
+        if(_instanceStride) {
+            auto mapped = _instances.map(slot, static_cast<uint32_t>(_instanceData.size()), &grew);
+            auto out = mapped.data();
+            for(auto index : _order) {
+                memcpy(out, _instanceData.data() + _items[index].instanceOffset, _instanceStride);
+                out += _instanceStride;
+            }
+
+            //
+            VkBuffer instanceBuffers[] = {_instances[slot].buffer};
+            VkDeviceSize offsets[] = {0};
+            vkCmdBindVertexBuffers(cmdBuf, VertexLayout::INSTANCE_BINDING, 1, instanceBuffers, offsets);
+        }
+
+        //
+        _after = {};
+        const Item* bound = nullptr;
+        for(size_t first = 0; first < _order.size();) {
+            auto &item = _items[_order[first]];
+
+            // identical draws merge into one
+            auto last = first + 1;
+            while(last < _order.size() && _items[_order[last]].key == item.key) last++;
+
+            //
+            _bind(cmdBuf, bound, item, _after);
+            bound = &item;
+
+            //
+            auto instanceCount = static_cast<uint32_t>(last - first);
+            vkCmdDrawIndexed(cmdBuf, item.geometry.indexCount, instanceCount, item.geometry.firstIndex, item.geometry.vertexOffset, static_cast<uint32_t>(first));
+            _after.draws++;
+            _after.instances += instanceCount;
+
+            //
+            first = last;
+        }
+
+        return grew;
+    }
+
+    // binds and draws of the last recorded list, as submitted
+    const Stats& statsBeforeBatching() const {
+        return _before;
+    }
+
+    // binds and draws actually recorded
+    const Stats& statsAfterBatching() const {
+        return _after;
+    }
+
+ private:
+    struct Item {
+        uint64_t key = 0;
+        const Pipeline* pipeline = nullptr;
+        Geometry geometry;
+        Material material;
+        uint32_t instanceOffset = 0;
+    };
+
+    // from most to least expensive state change :
+    // pipeline (12 bits) | material (16 bits) | vertex and index buffers (12 bits) | geometry (24 bits)
+    static constexpr int GEOMETRY_BITS = 24;
+    static constexpr int BUFFERS_BITS = 12;
+    static constexpr int MATERIAL_BITS = 16;
+    static constexpr int PIPELINE_BITS = 12;
+
+    const uint32_t _instanceStride;
+    DynamicBuffer<std::byte> _instances;
+
+    std::vector<Item> _items;
+    std::vector<uint32_t> _order; // indices of "_items", sorted by key
+    std::vector<std::byte> _instanceData;
+    Stats _before;
+    Stats _after;
+
+    // dense ids in order of appearance, rebuilt for each list
+    std::map<const Pipeline*, uint64_t> _pipelineIds;
+    std::map<std::tuple<VkDescriptorSet, bool, uint32_t>, uint64_t> _materialIds;
+    std::map<std::tuple<VkBuffer, VkBuffer, VkIndexType>, uint64_t> _buffersIds;
+    std::map<std::tuple<VkBuffer, VkBuffer, VkIndexType, uint32_t, uint32_t, int32_t>, uint64_t> _geometryIds;
+
+    template<class K>
+    static uint64_t _idOf(std::map<K, uint64_t>& ids, const K& key, int bits) {
+        auto [found, inserted] = ids.emplace(key, ids.size());
+        assert(found->second < (uint64_t(1) << bits));
+        return found->second;
+    }
+
+    uint64_t _key(const Pipeline* pipeline, const Geometry& g, const Material& material) {
+        auto pipelineId = _idOf(_pipelineIds, pipeline, PIPELINE_BITS);
+        auto materialId = _idOf(_materialIds, std::make_tuple(material.descriptorSet, material.dynamicOffset.has_value(), material.dynamicOffset.value_or(0)), MATERIAL_BITS);
+        auto buffersId = _idOf(_buffersIds, std::make_tuple(g.vertexBuffer, g.indexBuffer, g.indexType), BUFFERS_BITS);
+        auto geometryId = _idOf(_geometryIds, std::make_tuple(g.vertexBuffer, g.indexBuffer, g.indexType, g.firstIndex, g.indexCount, g.vertexOffset), GEOMETRY_BITS);
+
+        //
+        return pipelineId << (MATERIAL_BITS + BUFFERS_BITS + GEOMETRY_BITS)
+            | materialId << (BUFFERS_BITS + GEOMETRY_BITS)
+            | buffersId << GEOMETRY_BITS
+            | geometryId;
+    }
+
+    static uint64_t _pipelineOf(uint64_t key) {
+        return key >> (MATERIAL_BITS + BUFFERS_BITS + GEOMETRY_BITS);
+    }
+
+    static uint64_t _materialOf(uint64_t key) {
+        return (key >> (BUFFERS_BITS + GEOMETRY_BITS)) & ((uint64_t(1) << MATERIAL_BITS) - 1);
+    }
+
+    static uint64_t _buffersOf(uint64_t key) {
+        return (key >> GEOMETRY_BITS) & ((uint64_t(1) << BUFFERS_BITS) - 1);
+    }
+
+    // only binds what differs from "bound", or everything if nothing is; "cmdBuf" may be null to only count
+    static void _bind(VkCommandBuffer cmdBuf, const Item* bound, const Item& item, Stats& stats) {
+        auto pipelineChanged = !bound || _pipelineOf(bound->key) != _pipelineOf(item.key);
+        if(pipelineChanged) {
+            if(cmdBuf) vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, *item.pipeline);
+            stats.pipelineBinds++;
+        }
+
+        //
+        if(pipelineChanged || _materialOf(bound->key) != _materialOf(item.key)) {
+            if(cmdBuf) {
+                auto &material = item.material;
+                vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, item.pipeline->layout(), 0, 1, &material.descriptorSet, 
+                    material.dynamicOffset ? 1 : 0, 
+                    material.dynamicOffset ? &*material.dynamicOffset : nullptr
+                );
+            }
+            stats.descriptorBinds++;
+        }
+
+        //
+        if(!bound || _buffersOf(bound->key) != _buffersOf(item.key)) {
+            if(cmdBuf) {
+                VkBuffer vertexBuffers[] = {item.geometry.vertexBuffer};
+                VkDeviceSize offsets[] = {0};
+                vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+                vkCmdBindIndexBuffer(cmdBuf, item.geometry.indexBuffer, 0, item.geometry.indexType);
+            }
+            stats.geometryBinds++;
+        }
+    }
+
+    static Stats _simulate(const std::vector<Item>& items) {
+        Stats stats;
+        const Item* bound = nullptr;
+        for(const auto &item : items) {
+            _bind(VK_NULL_HANDLE, bound, item, stats);
+            bound = &item;
+            stats.draws++;
+            stats.instances++;
+        }
+        return stats;
+    }
+};
+
+} // namespace Vulcain
@@ -0,0 +1,255 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "helpers/Frustum.hpp"
+#include "common/ThreadPool.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include <bit>
+#include <cfloat>
+#include <chrono>
+#include <span>
+#include <vector>
+
+namespace Vulcain {
+
+// CPU side visibility of bounding spheres, stored as structure of arrays so that planes are tested against 8 (AVX) or 4 (SSE) objects at once.
+// The instruction set is picked at compile time (eg. "-mavx2"), scalar code being the fallback.
+// Large sets are split into tasks spread over a "ThreadPool", if any.
+class FrustumCuller {
+ public:
+    // storage is padded to the widest lanes count, with spheres that are never visible
+    static constexpr uint32_t LANES = 8;
+    static constexpr uint32_t OBJECTS_PER_TASK = 4096;
+
+    struct Stats {
+        uint32_t objects = 0;
+        uint32_t visible = 0;
+        double seconds = 0;
+
+        double objectsPerSecond() const {
+            return seconds > 0 ? objects / seconds : 0;
+        }
+    };
+
+    explicit FrustumCuller(ThreadPool* threads = nullptr) : _threads(threads) {}
+
+    static constexpr const char* instructionSet() {
+        #if defined(__AVX__)
+        return "AVX";
+        #elif defined(__SSE2__) || defined(_M_X64)
+        return "SSE2";
+        #else
+        return "scalar";
+        #endif
+    }
+
+    // returns the object index, as found in "cull()" results
+    uint32_t add(const glm::vec3& center, float radius) {
+        if(_count == _radius.size()) _grow(_count + LANES);
+        auto index = _count++;
+        set(index, center, radius);
+        return index;
+    }
+
+    void set(uint32_t index, const glm::vec3& center, float radius) {
+        assert(index < _count);
+        _x[index] = center.x;
+        _y[index] = center.y;
+        _z[index] = center.z;
+        _radius[index] = radius;
+    }
+
+    void reserve(uint32_t count) {
+        if(count > _radius.size()) _grow(count);
+    }
+
+    void clear() {
+        _count = 0;
+        std::fill(_radius.begin(), _radius.end(), NEVER_VISIBLE);
+    }
+
+    uint32_t size() const {
+        return _count;
+    }
+
+    // indices of spheres intersecting the frustum, in ascending order; valid until next call
+    std::span<const uint32_t> cull(const Frustum& frustum) {
+        auto start = std::chrono::steady_clock::now();
+
+        //
+        Planes planes;
+        for(int p = 0; p < 6; p++) {
+            planes.nx[p] = frustum.planes[p].x;
+            planes.ny[p] = frustum.planes[p].y;
+            planes.nz[p] = frustum.planes[p].z;
+            planes.d[p] = frustum.planes[p].w;
+        }
+
+        // padded, so that every task covers whole lanes
+        auto padded = (_count + LANES - 1) / LANES * LANES;
+        auto tasksCount = (padded + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK;
+        if(_tasks.size() < tasksCount) _tasks.resize(tasksCount);
+
+        //
+        auto cullTask = [this, &planes, padded](uint32_t task, uint32_t) {
+            auto begin = task * OBJECTS_PER_TASK;
+            auto end = std::min(begin + OBJECTS_PER_TASK, padded);
+            auto &result = _tasks[task];
+            if(result.indices.size() < OBJECTS_PER_TASK) result.indices.resize(OBJECTS_PER_TASK);
+            result.count = _cullRange(planes, begin, end, result.indices.data());
+        };
+
+        if(_threads) {
+            _threads->parallelFor(tasksCount, cullTask);
+        } else {
+            for(uint32_t i = 0; i < tasksCount; i++) cullTask(i, 0);
+        }
+
+        // gather, keeping objects order
+        uint32_t visibleCount = 0;
+        for(uint32_t i = 0; i < tasksCount; i++) {
+            visibleCount += _tasks[i].count;
+        }
+
+        _visible.resize(visibleCount);
+        auto out = _visible.data();
+        for(uint32_t i = 0; i < tasksCount; i++) {
+            out = std::copy_n(_tasks[i].indices.data(), _tasks[i].count, out);
+        }
+
+        //
+        _stats.objects = _count;
+        _stats.visible = visibleCount;
+        _stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        //
+        return _visible;
+    }
+
+    const Stats& lastStats() const {
+        return _stats;
+    }
+
+ private:
+    static constexpr float NEVER_VISIBLE = -FLT_MAX;
+
+    struct Planes {
+        float nx[6];
+        float ny[6];
+        float nz[6];
+        float d[6];
+    };
+
+    struct TaskResult {
+        std::vector<uint32_t> indices;
+        uint32_t count = 0;
+    };
+
+    ThreadPool* _threads = nullptr;
+
+    uint32_t _count = 0;
+    std::vector<float> _x;
+    std::vector<float> _y;
+    std::vector<float> _z;
+    std::vector<float> _radius;
+
+    std::vector<TaskResult> _tasks;
+    std::vector<uint32_t> _visible;
+    Stats _stats;
+
+    void _grow(uint32_t atLeast) {
+        auto capacity = std::max<uint32_t>(atLeast, static_cast<uint32_t>(_radius.size()) * 2);
+        capacity = (capacity + LANES - 1) / LANES * LANES;
+        _x.resize(capacity, 0);
+        _y.resize(capacity, 0);
+        _z.resize(capacity, 0);
+        _radius.resize(capacity, NEVER_VISIBLE);
+    }
+
+    // [begin, end[ is a multiple of "LANES"; returns how many indices were written to "out"
+    uint32_t _cullRange(const Planes& planes, uint32_t begin, uint32_t end, uint32_t* out) const {
+        uint32_t written = 0;
+        auto x = _x.data(), y = _y.data(), z = _z.data(), r = _radius.data();
+
+        #if defined(__AVX__)
+        for(auto i = begin; i < end; i += 8) {
+            auto X = _mm256_loadu_ps(x + i), Y = _mm256_loadu_ps(y + i), Z = _mm256_loadu_ps(z + i);
+            auto negR = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(r + i));
+
+            auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(int p = 0; p < 6; p++) {
+                auto distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nx[p]), X), _mm256_mul_ps(_mm256_set1_ps(planes.ny[p]), Y)),
+                    _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.nz[p]), Z), _mm256_set1_ps(planes.d[p]))
+                );
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negR, _CMP_GT_OQ));
+            }
+
+            written = _compact(static_cast<uint32_t>(_mm256_movemask_ps(inside)), i, out, written);
+        }
+        #elif defined(__SSE2__) || defined(_M_X64)
+        for(auto i = begin; i < end; i += 4) {
+            auto X = _mm_loadu_ps(x + i), Y = _mm_loadu_ps(y + i), Z = _mm_loadu_ps(z + i);
+            auto negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(r + i));
+
+            auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for(int p = 0; p < 6; p++) {
+                auto distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nx[p]), X), _mm_mul_ps(_mm_set1_ps(planes.ny[p]), Y)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.nz[p]), Z), _mm_set1_ps(planes.d[p]))
+                );
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negR));
+            }
+
+            written = _compact(static_cast<uint32_t>(_mm_movemask_ps(inside)), i, out, written);
+        }
+        #else
+        for(auto i = begin; i < end; i++) {
+            bool inside = true;
+            for(int p = 0; p < 6; p++) {
+                auto distance = planes.nx[p] * x[i] + planes.ny[p] * y[i] + planes.nz[p] * z[i] + planes.d[p];
+                inside &= distance > -r[i];
+            }
+            if(inside) out[written++] = i;
+        }
+        #endif
+
+        return written;
+    }
+
+    // one index per set bit of "mask", lane 0 first
+    static uint32_t _compact(uint32_t mask, uint32_t first, uint32_t* out, uint32_t written) {
+        while(mask) {
+            out[written++] = first + static_cast<uint32_t>(std::countr_zero(mask));
+            mask &= mask - 1;
+        }
+        return written;
+    }
+};
+
+} // namespace Vulcain
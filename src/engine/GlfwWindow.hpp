@@ -20,10 +20,10 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <iostream>
 
 #include <GLFW/glfw3.h>
-#include <GLFW/glfw3native.h>
 
 #include "common/IDrawer.h"
 
@@ -43,6 +43,9 @@ class GlfwWindow {
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
         _window = glfwCreateWindow(800, 600, "Vulkan window", nullptr, nullptr);
         glfwSetWindowUserPointer(_window, this);
+
+        //
+        _bindInputTimestamps();
     }
 
     ~GlfwWindow() {
@@ -57,8 +60,8 @@ class GlfwWindow {
         }
     }
 
-    HWND handle() const {
-        return glfwGetWin32Window(_window);
+    GLFWwindow* handle() const {
+        return _window;
     }
 
     VkExtent2D framebufferSize() const {
@@ -71,6 +74,11 @@ class GlfwWindow {
         };
     }
 
+    // when the most recent key, mouse button or cursor event was received, epoch if none
+    std::chrono::steady_clock::time_point lastInputTime() const {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(_lastInput.load()));
+    }
+
     void waitUntilSwapchainIsLegal() const {
         //
         int width, height;
@@ -103,6 +111,27 @@ class GlfwWindow {
  private:
     GLFWwindow* _window = nullptr;
 
+    // steady clock ticks, for input latency measurement
+    std::atomic<std::chrono::steady_clock::rep> _lastInput = 0;
+
+    static void _stampInput(GLFWwindow* window) {
+        auto handler = reinterpret_cast<GlfwWindow*>(glfwGetWindowUserPointer(window));
+        handler->_lastInput = std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    void _bindInputTimestamps() {
+        // captureless lambdas only, as GLFW expects function pointers
+        glfwSetKeyCallback(_window, [](GLFWwindow* window, int, int, int, int) {
+            _stampInput(window);
+        });
+        glfwSetMouseButtonCallback(_window, [](GLFWwindow* window, int, int, int) {
+            _stampInput(window);
+        });
+        glfwSetCursorPosCallback(_window, [](GLFWwindow* window, double, double) {
+            _stampInput(window);
+        });
+    }
+
     std::atomic<bool>* _framebufferChangedFlag = nullptr;
     IDrawer* _drawer = nullptr;
 };
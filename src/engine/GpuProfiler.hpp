@@ -0,0 +1,297 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include "Device.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Vulcain {
+
+// GPU time of nested scopes, written as timestamps into command buffers, along with vertex and fragment
+// invocations where pipeline statistics are supported. Each slot (a command buffer being replayed, eg. a swapchain image)
+// owns its query pools, read back without waiting once the slot's previous submission is known complete.
+// Scopes must be opened and closed from the thread recording the slot's primary, within a same render pass instance if begun inside one.
+class GpuProfiler : public DeviceBound {
+ public:
+    static constexpr uint32_t NO_SCOPE = UINT32_MAX;
+
+    struct ScopeResult {
+        std::string name;
+        uint32_t depth = 0;
+        double ms = 0;
+        bool hasStatistics = false;
+        uint64_t vertexInvocations = 0;
+        uint64_t fragmentInvocations = 0;
+    };
+
+    // closes its scope when going out of scope; does nothing if "profiler" is null
+    class Zone {
+     public:
+        Zone(GpuProfiler* profiler, VkCommandBuffer cmdBuf, size_t slot, std::string name, bool statistics = true) :
+            _profiler(profiler), _cmdBuf(cmdBuf), _slot(slot) {
+            if(_profiler) _scope = _profiler->begin(_cmdBuf, _slot, std::move(name), statistics);
+        }
+
+        ~Zone() {
+            if(_profiler) _profiler->end(_cmdBuf, _slot, _scope);
+        }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+     private:
+        GpuProfiler* _profiler = nullptr;
+        VkCommandBuffer _cmdBuf;
+        size_t _slot;
+        uint32_t _scope = NO_SCOPE;
+    };
+
+    GpuProfiler(const Device* device, uint32_t maxScopes = 64) : 
+        DeviceBound(device),
+        _maxScopes(maxScopes),
+        _timestampMask(_maskOf(device->timestampValidBits(device->queueIndex()))),
+        _timestampPeriod(device->properties().limits.timestampPeriod),
+        _hasStatistics(device->features().pipelineStatisticsQuery) {
+        assert(maxScopes);
+    }
+
+    ~GpuProfiler() {
+        for(auto &slot : _slots) {
+            vkDestroyQueryPool(*_device, slot.timestamps, nullptr);
+            vkDestroyQueryPool(*_device, slot.statistics, nullptr);
+        }
+    }
+
+    // false if the graphics family cannot write timestamps, making every call a no-op
+    bool isEnabled() const {
+        return _timestampMask != 0;
+    }
+
+    bool hasStatistics() const {
+        return _hasStatistics;
+    }
+
+    // outside any render pass, before the slot's first scope is recorded : forgets its previous scopes
+    void beginSlot(VkCommandBuffer cmdBuf, size_t slot) {
+        if(!isEnabled()) return;
+
+        //
+        if(_slots.size() <= slot) _createSlots(slot + 1);
+        auto &pools = _slots[slot];
+        pools.scopes.clear();
+        pools.depth = 0;
+        pools.statisticsCount = 0;
+        pools.hasOpenStatistics = false;
+        pools.isSubmitted = false;
+
+        //
+        vkCmdResetQueryPool(cmdBuf, pools.timestamps, 0, _maxScopes * 2);
+        if(pools.statistics) vkCmdResetQueryPool(cmdBuf, pools.statistics, 0, _maxScopes);
+    }
+
+    // statistics are only captured by the outermost scope asking for them, as such queries cannot nest.
+    // NO_SCOPE if disabled or too many scopes were opened on this slot
+    uint32_t begin(VkCommandBuffer cmdBuf, size_t slot, std::string name, bool statistics = true) {
+        if(!isEnabled()) return NO_SCOPE;
+        assert(slot < _slots.size());
+
+        //
+        auto &pools = _slots[slot];
+        if(pools.scopes.size() == _maxScopes) return NO_SCOPE;
+
+        //
+        auto index = static_cast<uint32_t>(pools.scopes.size());
+        auto &scope = pools.scopes.emplace_back();
+        scope.name = std::move(name);
+        scope.depth = pools.depth++;
+        vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pools.timestamps, index * 2);
+
+        //
+        if(statistics && pools.statistics && !pools.hasOpenStatistics) {
+            scope.statisticsQuery = pools.statisticsCount++;
+            pools.hasOpenStatistics = true;
+            vkCmdBeginQuery(cmdBuf, pools.statistics, scope.statisticsQuery, 0);
+        }
+
+        return index;
+    }
+
+    void end(VkCommandBuffer cmdBuf, size_t slot, uint32_t scopeIndex) {
+        if(scopeIndex == NO_SCOPE) return;
+
+        //
+        auto &pools = _slots[slot];
+        auto &scope = pools.scopes[scopeIndex];
+        assert(!scope.isClosed);
+        scope.isClosed = true;
+        pools.depth--;
+
+        //
+        if(scope.statisticsQuery != NO_SCOPE) {
+            vkCmdEndQuery(cmdBuf, pools.statistics, scope.statisticsQuery);
+            pools.hasOpenStatistics = false;
+        }
+        vkCmdWriteTimestamp(cmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pools.timestamps, scopeIndex * 2 + 1);
+    }
+
+    // recorded commands of "slot" were just submitted, their results can be collected once complete
+    void submitted(size_t slot) {
+        if(slot < _slots.size()) _slots[slot].isSubmitted = true;
+    }
+
+    // once the last submission of "slot" is complete, eg. its fence waited; never blocks.
+    // Returns false if nothing was available, "lastResults()" being left untouched
+    bool collect(size_t slot) {
+        if(slot >= _slots.size()) return false;
+        auto &pools = _slots[slot];
+        if(!pools.isSubmitted || pools.scopes.empty()) return false;
+
+        //
+        auto scopesCount = static_cast<uint32_t>(pools.scopes.size());
+        _ticks.resize(scopesCount * 2);
+        auto result = vkGetQueryPoolResults(
+            *_device, pools.timestamps,
+            0, scopesCount * 2,
+            _ticks.size() * sizeof(uint64_t), _ticks.data(), sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT
+        );
+        if(result != VK_SUCCESS) return false;
+
+        // vertex then fragment invocations, following flags bits order
+        if(pools.statisticsCount) {
+            _invocations.resize(pools.statisticsCount * 2);
+            result = vkGetQueryPoolResults(
+                *_device, pools.statistics,
+                0, pools.statisticsCount,
+                _invocations.size() * sizeof(uint64_t), _invocations.data(), 2 * sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT
+            );
+            if(result != VK_SUCCESS) return false;
+        }
+
+        //
+        _lastResults.resize(scopesCount);
+        for(uint32_t i = 0; i < scopesCount; i++) {
+            auto &scope = pools.scopes[i];
+            auto &out = _lastResults[i];
+            out.name = scope.name;
+            out.depth = scope.depth;
+            out.ms = _toMs((_ticks[i * 2 + 1] - _ticks[i * 2]) & _timestampMask);
+            out.hasStatistics = scope.statisticsQuery != NO_SCOPE;
+            out.vertexInvocations = out.hasStatistics ? _invocations[scope.statisticsQuery * 2] : 0;
+            out.fragmentInvocations = out.hasStatistics ? _invocations[scope.statisticsQuery * 2 + 1] : 0;
+        }
+
+        //
+        _collectedFrames++;
+        return true;
+    }
+
+    // scopes of the most recently collected frame, in opening order
+    const std::vector<ScopeResult>& lastResults() const {
+        return _lastResults;
+    }
+
+    uint64_t collectedFrames() const {
+        return _collectedFrames;
+    }
+
+    // indented by depth, one scope per line
+    friend std::ostream& operator<<(std::ostream& os, const GpuProfiler& profiler) {
+        for(auto const &scope : profiler._lastResults) {
+            os << std::string(scope.depth * 2, ' ') << scope.name << " : " << scope.ms << " ms";
+            if(scope.hasStatistics) {
+                os << ", " << scope.vertexInvocations << " vertex / " << scope.fragmentInvocations << " fragment invocations";
+            }
+            os << '\n';
+        }
+        return os;
+    }
+
+ private:
+    struct Scope {
+        std::string name;
+        uint32_t depth = 0;
+        uint32_t statisticsQuery = NO_SCOPE;
+        bool isClosed = false;
+    };
+
+    struct Slot {
+        VkQueryPool timestamps = VK_NULL_HANDLE;
+        VkQueryPool statistics = VK_NULL_HANDLE;
+        std::vector<Scope> scopes;
+        uint32_t depth = 0;
+        uint32_t statisticsCount = 0;
+        bool hasOpenStatistics = false;
+        bool isSubmitted = false;
+    };
+
+    const uint32_t _maxScopes;
+    const uint64_t _timestampMask;
+    const float _timestampPeriod;
+    const bool _hasStatistics;
+
+    std::vector<Slot> _slots;
+    std::vector<uint64_t> _ticks;
+    std::vector<uint64_t> _invocations;
+    std::vector<ScopeResult> _lastResults;
+    uint64_t _collectedFrames = 0;
+
+    // timestamps wrap around past their valid bits
+    static uint64_t _maskOf(uint32_t validBits) {
+        if(validBits >= 64) return UINT64_MAX;
+        return (uint64_t{1} << validBits) - 1;
+    }
+
+    double _toMs(uint64_t ticks) const {
+        return static_cast<double>(ticks) * _timestampPeriod / 1e6;
+    }
+
+    void _createSlots(size_t count) {
+        VkQueryPoolCreateInfo timestampsInfo{};
+        timestampsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        timestampsInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        timestampsInfo.queryCount = _maxScopes * 2;
+
+        VkQueryPoolCreateInfo statisticsInfo{};
+        statisticsInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        statisticsInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        statisticsInfo.queryCount = _maxScopes;
+        statisticsInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        //
+        while(_slots.size() < count) {
+            auto &slot = _slots.emplace_back();
+
+            auto result = vkCreateQueryPool(*_device, &timestampsInfo, nullptr, &slot.timestamps);
+            assert(result == VK_SUCCESS);
+
+            if(!_hasStatistics) continue;
+            result = vkCreateQueryPool(*_device, &statisticsInfo, nullptr, &slot.statistics);
+            assert(result == VK_SUCCESS);
+        }
+    }
+};
+
+} // namespace Vulcain
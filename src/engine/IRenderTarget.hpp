@@ -0,0 +1,98 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include "Device.hpp"
+#include "RenderSettings.hpp"
+#include "common/IRegenerable.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace Vulcain {
+
+// Images a render pass draws into, presented or not : root of the regeneration tree (render pass, image views, command pools...).
+// Implementations fill "imageFormat", "imageExtent" and images on "_gen()"
+class IRenderTarget : public DeviceBound, public IRegenerator {
+ public:
+    VkFormat imageFormat = VK_FORMAT_UNDEFINED;
+    VkExtent2D imageExtent {};
+
+    IRenderTarget(const Device* device, const RenderSettings& settings) : DeviceBound(device) {
+        setSettings(settings);
+    }
+    virtual ~IRenderTarget() = default;
+
+    auto imagesCount() const {
+        return _images.size();
+    }
+
+    const std::vector<VkImage>& images() const {
+        return _images;
+    }
+
+    const Device* device() const {
+        return _device;
+    }
+
+    const RenderSettings& settings() const {
+        return _settings;
+    }
+
+    // images count (and present mode, if presented) change on next "regenerate()".
+    // Frames in flight size per-frame arrays, so must stay within [1, MAX_FRAMES_IN_FLIGHT]
+    void setSettings(const RenderSettings& settings) {
+        if(settings.framesInFlight < 1 || settings.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+            throw std::invalid_argument("framesInFlight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+        }
+        _settings = settings;
+    }
+
+    // layout images are left in by the render pass
+    virtual VkImageLayout finalLayout() const = 0;
+
+    VkViewport defaultViewport() const {
+        VkViewport viewport{};
+
+        //
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = (float) this->imageExtent.width;
+        viewport.height = (float) this->imageExtent.height;
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        //
+        return viewport;
+    }
+
+    VkRect2D defaultScissor() const {
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = this->imageExtent;
+        return scissor;
+    }
+
+ protected:
+    std::vector<VkImage> _images;
+    RenderSettings _settings;
+};
+
+} // namespace Vulcain
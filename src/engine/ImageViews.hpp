@@ -31,7 +31,7 @@ class ImageViews : public DeviceBound, public IRegenerable {
 
     // how many images handled
     auto imagesCount() const {
-        return _renderpass->swapchain()->imagesCount();
+        return _renderpass->target()->imagesCount();
     }
 
     const Renderpass* renderpass() const {
@@ -51,13 +51,13 @@ class ImageViews : public DeviceBound, public IRegenerable {
     std::vector<VkFramebuffer> _fbs;
     const Renderpass* _renderpass = nullptr;
 
-    void _pushImageView(const Swapchain* swapchain, VkImage swapChainImage, VkImageView* into) {
+    void _pushImageView(const IRenderTarget* target, VkImage image, VkImageView* into) {
         //
         VkImageViewCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        createInfo.image = swapChainImage;
+        createInfo.image = image;
         createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format = swapchain->imageFormat;
+        createInfo.format = target->imageFormat;
         createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
         createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
         createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -73,7 +73,7 @@ class ImageViews : public DeviceBound, public IRegenerable {
         assert(result == VK_SUCCESS);
     }
 
-    void _pushFramebuffer(const Swapchain* swapchain, const Renderpass* renderpass, VkImageView targetView, VkFramebuffer* into) {
+    void _pushFramebuffer(const IRenderTarget* target, const Renderpass* renderpass, VkImageView targetView, VkFramebuffer* into) {
         //
         VkFramebufferCreateInfo framebufferInfo{};
         framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -83,8 +83,8 @@ class ImageViews : public DeviceBound, public IRegenerable {
             targetView
         };
         framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = swapchain->imageExtent.width;
-        framebufferInfo.height = swapchain->imageExtent.height;
+        framebufferInfo.width = target->imageExtent.width;
+        framebufferInfo.height = target->imageExtent.height;
         framebufferInfo.layers = 1;
 
         //
@@ -94,18 +94,18 @@ class ImageViews : public DeviceBound, public IRegenerable {
 
     void _gen() final {
         //
-        auto swapchain = _renderpass->swapchain();
-        auto swapChainImages = swapchain->images();
+        auto target = _renderpass->target();
+        auto const &images = target->images();
         
         //
-        auto imgsCount = swapChainImages.size();
+        auto imgsCount = images.size();
         _views.resize(imgsCount);
         _fbs.resize(imgsCount);
 
         //
-        for(size_t i = 0; i < swapChainImages.size(); i++) {
-            _pushImageView(swapchain, swapChainImages[i], &_views[i]);
-            _pushFramebuffer(swapchain, _renderpass, _views[i], &_fbs[i]);
+        for(size_t i = 0; i < images.size(); i++) {
+            _pushImageView(target, images[i], &_views[i]);
+            _pushFramebuffer(target, _renderpass, _views[i], &_fbs[i]);
         }
     }
 
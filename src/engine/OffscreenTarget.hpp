@@ -0,0 +1,100 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include "IRenderTarget.hpp"
+
+#include <utility>
+
+namespace Vulcain {
+
+// Device-local images rendered into without any window, surface or presentation, eg. for benchmarks and CI on display-less machines.
+// Images are used round-robin by "Renderer", and left ready to be copied from once rendered
+class OffscreenTarget : public IRenderTarget {
+ public:
+    // images count is "settings.imageCount", frames in flight if empty; present modes are ignored
+    OffscreenTarget(const Device* device, VkExtent2D extent, const RenderSettings& settings = {}, VkFormat format = VK_FORMAT_R8G8B8A8_UNORM) : 
+        IRenderTarget(device, settings) {
+        assert(extent.width && extent.height);
+        this->imageFormat = format;
+        this->imageExtent = extent;
+
+        //
+        _gen();
+    }
+
+    ~OffscreenTarget() {
+        _degen();
+    }
+
+    VkImageLayout finalLayout() const final {
+        return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    }
+
+    // applied on next "regenerate()", eg. through "Renderer::applySettings()"
+    void resize(VkExtent2D extent) {
+        assert(extent.width && extent.height);
+        _nextExtent = extent;
+    }
+
+ private:
+    std::vector<VmaAllocation> _allocations;
+    std::optional<VkExtent2D> _nextExtent;
+
+    void _gen() final {
+        if(_nextExtent) this->imageExtent = *std::exchange(_nextExtent, std::nullopt);
+
+        //
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = this->imageFormat;
+        imageInfo.extent = { this->imageExtent.width, this->imageExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        //
+        auto imagesCount = std::max(_settings.imageCount.value_or(_settings.framesInFlight), 1u);
+        _images.resize(imagesCount);
+        _allocations.resize(imagesCount);
+        for(uint32_t i = 0; i < imagesCount; i++) {
+            auto result = vmaCreateImage(_device->allocator(), &imageInfo, &allocInfo, &_images[i], &_allocations[i], nullptr);
+            assert(result == VK_SUCCESS);
+        }
+    }
+
+    void _degen() final {
+        for(size_t i = 0; i < _images.size(); i++) {
+            vmaDestroyImage(_device->allocator(), _images[i], _allocations[i]);
+        }
+        _images.clear();
+        _allocations.clear();
+    }
+};
+
+} // namespace Vulcain
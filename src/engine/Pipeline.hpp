@@ -25,6 +25,7 @@
 #include "engine/DescriptorPools.hpp"
 
 #include "buffers/UniformBuffers.hpp"
+#include "buffers/Vertex.hpp"
 
 #include "toys/UBO.hpp"
 
@@ -34,17 +35,20 @@ namespace Vulcain {
 
 class Pipeline : public DeviceBound, public IRegenerable {
  public:
-    Pipeline(const Renderpass* renderpass, DescriptorPools* descrPools, const ShaderFoundry::Modules& modules) : 
+    // if "dynamicObjectsCount" is set, uniforms are sliced from a ring buffer and bound with dynamic offsets.
+    // "vertexLayout" describes vertex input, as given by "VertexLayout::of<V>()".
+    // if "sharedUniforms" is set, every image binds the same uniforms, filled by "recordUniformsCopy()"
+    Pipeline(const Renderpass* renderpass, DescriptorPools* descrPools, const ShaderFoundry::Modules& modules, uint32_t dynamicObjectsCount = 0, const VertexLayout& vertexLayout = VertexLayout::of<Vertex>(), bool sharedUniforms = false) : 
         DeviceBound(renderpass), 
         IRegenerable(descrPools), 
-        _swapchain(renderpass->swapchain()), 
         _descrPool(descrPools), 
-        _uniformBuffers(descrPools) {
+        _target(renderpass->target()), 
+        _uniformBuffers(descrPools, dynamicObjectsCount, sharedUniforms) {
         //
         _createDescriptorSetLayout();
         _gen();
         _createPipelineLayout();
-        _createPipeline(_swapchain, renderpass, modules);
+        _createPipeline(renderpass, modules, vertexLayout);
     }
 
     operator VkPipeline() const { return _pipeline; }
@@ -56,10 +60,24 @@ class Pipeline : public DeviceBound, public IRegenerable {
     }
 
     void updateUniformBuffer(uint32_t currentImage) {
-        auto generated = spinUBO(_swapchain->imageExtent);
+        auto generated = spinUBO(_target->imageExtent);
         _uniformBuffers.mapToMemory(currentImage, generated);
     }
 
+    void updateUniformBuffer(uint32_t currentImage, const UniformBufferObject& ubo, uint32_t objectIndex = 0) {
+        _uniformBuffers.mapToMemory(currentImage, ubo, objectIndex);
+    }
+
+    // for shared uniforms, to be called from a "CommandPool" prologue
+    void recordUniformsCopy(VkCommandBuffer commandBuffer, uint32_t currentImage) const {
+        _uniformBuffers.recordCopyToShared(commandBuffer, currentImage);
+    }
+
+    // to be passed to vkCmdBindDescriptorSets if pipeline uses dynamic uniforms
+    uint32_t dynamicOffset(uint32_t currentImage, uint32_t objectIndex) const {
+        return _uniformBuffers.dynamicOffset(currentImage, objectIndex);
+    }
+
     VkPipelineLayout layout() const {
         return _layout;
     }
@@ -74,7 +92,7 @@ class Pipeline : public DeviceBound, public IRegenerable {
     VkDescriptorSetLayout _descriptorSetLayout;
 
     DescriptorPools* _descrPool = nullptr;
-    const Swapchain* _swapchain = nullptr;
+    const IRenderTarget* _target = nullptr;
     std::vector<VkDescriptorSet> _descriptorSets;
 
     UniformBuffers<UniformBufferObject> _uniformBuffers;
@@ -84,9 +102,9 @@ class Pipeline : public DeviceBound, public IRegenerable {
         _createDescriptorSets();
     }
 
-    void _createPipeline(const Swapchain* swapchain, const Renderpass* renderpass, const ShaderFoundry::Modules& modules) {
+    void _createPipeline(const Renderpass* renderpass, const ShaderFoundry::Modules& modules, const VertexLayout& vertexLayout) {
         //
-        PipelineBuilder builder;
+        PipelineBuilder builder(vertexLayout);
         
         //
         VkGraphicsPipelineCreateInfo pipelineInfo{};
@@ -115,6 +133,7 @@ class Pipeline : public DeviceBound, public IRegenerable {
     void _createDescriptorSetLayout() {
         //
         auto uboLayoutBinding = UniformBufferObject::binding();
+        uboLayoutBinding.descriptorType = _uniformBuffers.descriptorType();
 
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -127,13 +146,13 @@ class Pipeline : public DeviceBound, public IRegenerable {
 
     void _createDescriptorSets() {
 
-        auto imgsCount = _swapchain->imagesCount(); 
+        auto imgsCount = _target->imagesCount(); 
         //
         {
             std::vector<VkDescriptorSetLayout> layouts(imgsCount, _descriptorSetLayout);
             VkDescriptorSetAllocateInfo allocInfo{};
             allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            allocInfo.descriptorPool = _descrPool->pool(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+            allocInfo.descriptorPool = _descrPool->pool(_uniformBuffers.descriptorType());
             allocInfo.descriptorSetCount = static_cast<uint32_t>(imgsCount);
             allocInfo.pSetLayouts = layouts.data();
 
@@ -153,7 +172,7 @@ class Pipeline : public DeviceBound, public IRegenerable {
             descriptorWrite.dstSet = _descriptorSets[i];
             descriptorWrite.dstBinding = 0;
             descriptorWrite.dstArrayElement = 0;
-            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptorWrite.descriptorType = _uniformBuffers.descriptorType();
             descriptorWrite.descriptorCount = 1;
             descriptorWrite.pBufferInfo = &bufferInfo;
 
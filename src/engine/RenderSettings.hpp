@@ -0,0 +1,52 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "common/Vulcain.h"
+
+#include <optional>
+#include <vector>
+
+namespace Vulcain {
+
+// Latency / throughput tradeoffs, applied at runtime through "Renderer::applySettings()"
+struct RenderSettings {
+    // frames the CPU may record while the GPU still processes previous ones, in [1, MAX_FRAMES_IN_FLIGHT]
+    uint32_t framesInFlight = 2;
+
+    // swapchain images, clamped to surface limits; one more than the surface minimum if empty
+    std::optional<uint32_t> imageCount;
+
+    // first one supported by the surface is used, FIFO being always available otherwise
+    std::vector<VkPresentModeKHR> presentModes { VK_PRESENT_MODE_MAILBOX_KHR };
+
+    // deep queues and triple buffering, never starving the GPU
+    static RenderSettings throughput() {
+        return { MAX_FRAMES_IN_FLIGHT, 3, { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR } };
+    }
+
+    // a single queued frame and as few images as the surface allows, so that input is sampled as late as possible
+    static RenderSettings lowLatency() {
+        return { 1, 1, { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR } };
+    }
+};
+
+} // namespace Vulcain
@@ -19,18 +19,41 @@
 
 #include "Renderer.h"
 
-Vulcain::Renderer::Renderer(const CommandPool* cmdPool, Vulcain::GlfwWindow* window, Vulcain::Swapchain* swapchain) : 
+#include <algorithm>
+#include <vector>
+
+Vulcain::Renderer::Renderer(CommandPool* cmdPool, IRenderTarget* target, bool preferTimeline) : 
     DeviceBound(cmdPool), 
     _cmdPool(cmdPool), 
-    _swapchain(swapchain),
-    _window(window) {
+    _target(target) {
+    if(preferTimeline && Timeline::isSupported(_device)) {
+        _timeline = std::make_unique<Timeline>(_device);
+    }
     _createSyncObjects();
-    
+}
+
+Vulcain::Renderer::Renderer(CommandPool* cmdPool, Vulcain::GlfwWindow* window, Vulcain::Swapchain* swapchain, bool preferTimeline) : 
+    Renderer(cmdPool, static_cast<IRenderTarget*>(swapchain), preferTimeline) {
+    _swapchain = swapchain;
+    _window = window;
+
+    // actual present times are on CLOCK_MONOTONIC, which "steady_clock" only is there
+    #if defined(__linux__) || defined(__ANDROID__)
+    if(_device->hasExtension(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME)) {
+        _getPastPresentationTiming = reinterpret_cast<PFN_vkGetPastPresentationTimingGOOGLE>(
+            vkGetDeviceProcAddr(*_device, "vkGetPastPresentationTimingGOOGLE")
+        );
+    }
+    #endif
+
     //
     _window->_bindFramebufferChanges(&_hasFramebufferResized);
     _window->_bindDrawer(this);
 }
 
+Vulcain::Renderer::Renderer(CommandPool* cmdPool, OffscreenTarget* target, bool preferTimeline) : 
+    Renderer(cmdPool, static_cast<IRenderTarget*>(target), preferTimeline) {}
+
 Vulcain::Renderer::~Renderer() {
     // wait for device to stop processing
     vkDeviceWaitIdle(*_device);
@@ -39,7 +62,7 @@ Vulcain::Renderer::~Renderer() {
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(*_device, _renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(*_device, _imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence    (*_device, _inFlightFences[i], nullptr);
+        if(_inFlightFences[i]) vkDestroyFence(*_device, _inFlightFences[i], nullptr);
     }
 }
 
@@ -48,76 +71,187 @@ void Vulcain::Renderer::onBeforeWaitingCurrentImage(BeforeWaitingCurrentImageCal
     _onBeforeWaitingCurrentImage = cb;
 }
 
+void Vulcain::Renderer::scheduleCompute(ComputeScheduler* scheduler) {
+    _compute = scheduler;
+}
+
+const Vulcain::Timeline* Vulcain::Renderer::timeline() const {
+    return _timeline.get();
+}
+
+void Vulcain::Renderer::applySettings(const RenderSettings& settings) {
+    _target->setSettings(settings);
+    _regenerateSwapChain();
+}
+
+const Vulcain::Renderer::LatencyReport& Vulcain::Renderer::inputLatency() const {
+    return _inputLatency;
+}
+
+void Vulcain::Renderer::resetInputLatency() {
+    _inputLatency = {};
+}
+
+const Vulcain::FrameTimings& Vulcain::Renderer::timings() const {
+    return _timings;
+}
+
 void Vulcain::Renderer::draw() {
-    // wait fences from previous draw call
-    vkWaitForFences(*_device, 1, &_inFlightFences[_currentFrame], VK_TRUE, UINT64_MAX);
+    // time spent in each phase, since previous lap
+    FrameTimings::Record timing;
+    timing.frame = _drawnFrames;
+    auto lapStart = std::chrono::steady_clock::now();
+    auto lap = [&timing, &lapStart](FrameTimings::Phase phase) {
+        auto now = std::chrono::steady_clock::now();
+        timing.ms[phase] = std::chrono::duration<float, std::milli>(now - lapStart).count();
+        lapStart = now;
+    };
+
+    // wait previous draw call of this frame
+    _waitFrame(_currentFrame);
+    lap(FrameTimings::FRAME_WAIT);
+    _collectInputLatencies();
 
     uint32_t imageIndex;
     VkResult result;
 
     // acquire image
-    result = vkAcquireNextImageKHR(
-        *_device, 
-        *_swapchain, 
-        UINT64_MAX, 
-        _imageAvailableSemaphores[_currentFrame], 
-        VK_NULL_HANDLE, 
-        &imageIndex
-    );
+    result = _acquire(&imageIndex);
+    lap(FrameTimings::ACQUIRE);
 
-    // if swapchain is outdated
+    // if swapchain is outdated, nothing is drawn, but the hitch is still recorded
     if(result == VK_ERROR_OUT_OF_DATE_KHR) {
         _regenerateSwapChain();
+        lap(FrameTimings::REGENERATE);
+        _timings.push(timing);
+        _drawnFrames++;
         return;
     }
     // still allow submoptimal swapchain
     assert(result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR);
 
+    // input received up to now is reflected by this frame
+    _sampleInput(_currentFrame);
+
     // update uniform buffers there if any
     if(_onBeforeWaitingCurrentImage) _onBeforeWaitingCurrentImage(imageIndex);
+    lap(FrameTimings::BEFORE_IMAGE_WAIT_CALLBACK);
 
-    // if has an image in fight has fence on index, wait for it to be processed
-    if (_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(*_device, 1, &_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
-    }
-    _imagesInFlight[imageIndex] = _inFlightFences[_currentFrame];
+    // if image is still used by another frame, wait for it to be processed
+    _waitImage(imageIndex);
+    lap(FrameTimings::IMAGE_WAIT);
+
+    // previous submission of this image is complete, as are its GPU timings
+    auto profiler = _cmdPool->profiler();
+    if(profiler) profiler->collect(imageIndex);
+
+    // compute of this frame, either already submitted on its own queue or to be submitted along graphics
+    ComputeScheduler::Handoff compute;
+    if(_compute) compute = _compute->submit(_currentFrame);
 
     //prepare submission
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = {_imageAvailableSemaphores[_currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    // offscreen images are writable as soon as their previous frame completed, which was waited
+    VkSemaphore waitSemaphores[2];
+    VkPipelineStageFlags waitStages[2];
+    if(_swapchain) {
+        waitSemaphores[submitInfo.waitSemaphoreCount] = _imageAvailableSemaphores[_currentFrame];
+        waitStages[submitInfo.waitSemaphoreCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    if(compute.waitSemaphore) {
+        waitSemaphores[submitInfo.waitSemaphoreCount] = compute.waitSemaphore;
+        waitStages[submitInfo.waitSemaphoreCount++] = compute.waitStage;
+    }
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     
-    submitInfo.commandBufferCount = 1;
-    VkCommandBuffer buffers[] = {_cmdPool->commandBuffer(imageIndex)};
+    // frame fence has been waited, so a per-frame pool can be reset and recorded into
+    VkCommandBuffer buffers[4];
+    uint32_t buffersCount = 0;
+    for(uint32_t i = 0; i < compute.beforeGraphicsCount; i++) {
+        buffers[buffersCount++] = compute.beforeGraphics[i];
+    }
+    buffers[buffersCount++] = _cmdPool->commandBufferFor(_currentFrame, imageIndex);
+    if(compute.afterGraphics) buffers[buffersCount++] = compute.afterGraphics;
+    submitInfo.commandBufferCount = buffersCount;
     submitInfo.pCommandBuffers = buffers;
     
-    VkSemaphore signalSemaphores[] = {_renderFinishedSemaphores[_currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    // presentation only waits on binary semaphores, so the timeline is signaled alongside
+    VkSemaphore signalSemaphores[2];
+    if(_swapchain) signalSemaphores[submitInfo.signalSemaphoreCount++] = _renderFinishedSemaphores[_currentFrame];
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    vkResetFences(*_device, 1, &_inFlightFences[_currentFrame]);
+    if(_timeline) {
+        auto value = _timeline->advance();
 
-    result = vkQueueSubmit(_device->queue(), 1, &submitInfo, _inFlightFences[_currentFrame]);
-    assert(result == VK_SUCCESS);
+        // values of binary semaphores are ignored
+        uint64_t waitValues[] = {0, 0};
+        uint64_t signalValues[] = {0, 0};
+        signalValues[submitInfo.signalSemaphoreCount] = value;
+        signalSemaphores[submitInfo.signalSemaphoreCount++] = *_timeline;
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+        timelineInfo.pWaitSemaphoreValues = waitValues;
+        timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+        timelineInfo.pSignalSemaphoreValues = signalValues;
+        submitInfo.pNext = &timelineInfo;
+
+        //
+        _frameValues[_currentFrame] = value;
+        _imageValues[imageIndex] = value;
+
+        result = vkQueueSubmit(_device->queue(), 1, &submitInfo, VK_NULL_HANDLE);
+    } else {
+        _imagesInFlight[imageIndex] = _inFlightFences[_currentFrame];
+        vkResetFences(*_device, 1, &_inFlightFences[_currentFrame]);
 
-    VkSwapchainKHR swapChains[] = {*_swapchain};
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = &imageIndex;
-    presentInfo.pResults = nullptr; // Optional
+        result = vkQueueSubmit(_device->queue(), 1, &submitInfo, _inFlightFences[_currentFrame]);
+    }
+    assert(result == VK_SUCCESS);
+    if(profiler) profiler->submitted(imageIndex);
+    lap(FrameTimings::SUBMIT);
 
     // present queue results
-    result = vkQueuePresentKHR(_device->queue(), &presentInfo);
+    if(_swapchain) {
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &_renderFinishedSemaphores[_currentFrame];
+
+        VkSwapchainKHR swapChains[] = {*_swapchain};
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
+        presentInfo.pImageIndices = &imageIndex;
+        presentInfo.pResults = nullptr; // Optional
+
+        // tagged, so that the input this frame reflects is matched with its actual present time
+        VkPresentTimeGOOGLE presentTime{};
+        VkPresentTimesInfoGOOGLE presentTimes{};
+        if(_getPastPresentationTiming) {
+            presentTime.presentID = ++_presentID;
+            presentTimes.sType = VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE;
+            presentTimes.swapchainCount = 1;
+            presentTimes.pTimes = &presentTime;
+            presentInfo.pNext = &presentTimes;
+
+            //
+            auto &input = _frameInputs[_currentFrame];
+            if(input != std::chrono::steady_clock::time_point{}) {
+                _presentedInputs.emplace_back(presentTime.presentID, input);
+                input = {};
+            }
+
+            // some drivers never report presents, eg. of occluded windows
+            if(_presentedInputs.size() > PENDING_PRESENTS_MAX) _presentedInputs.pop_front();
+        }
+
+        result = vkQueuePresentKHR(_device->queue(), &presentInfo);
+    }
+    lap(FrameTimings::PRESENT);
 
     // check if framebuffer has been resized or swapchain image size suboptimal
     if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || _hasFramebufferResized) {
@@ -126,16 +260,150 @@ void Vulcain::Renderer::draw() {
     } else {
         assert(result == VK_SUCCESS);
     }
+    lap(FrameTimings::REGENERATE);
+
+    //
+    _timings.push(timing);
+    _drawnFrames++;
 
     // update current frame
-    _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    _currentFrame = (_currentFrame + 1) % _target->settings().framesInFlight;
+}
+
+VkResult Vulcain::Renderer::_acquire(uint32_t* imageIndex) {
+    if(!_swapchain) {
+        *imageIndex = _nextImage;
+        _nextImage = (_nextImage + 1) % static_cast<uint32_t>(_target->imagesCount());
+        return VK_SUCCESS;
+    }
+
+    //
+    return vkAcquireNextImageKHR(
+        *_device, 
+        *_swapchain, 
+        UINT64_MAX, 
+        _imageAvailableSemaphores[_currentFrame], 
+        VK_NULL_HANDLE, 
+        imageIndex
+    );
+}
+
+bool Vulcain::Renderer::_isFrameComplete(size_t frame) const {
+    if(_timeline) return _timeline->isReached(_frameValues[frame]);
+    return vkGetFenceStatus(*_device, _inFlightFences[frame]) == VK_SUCCESS;
+}
+
+void Vulcain::Renderer::_sampleInput(size_t frame) {
+    if(!_window) return;
+
+    //
+    auto input = _window->lastInputTime();
+    if(input <= _sampledInput) return;
+
+    //
+    _sampledInput = input;
+    _frameInputs[frame] = input;
+}
+
+// polls every frame, not only those currently in flight, since settings may have just changed.
+// Frames found complete finished at some point since previous draw, so "now" is an upper bound
+void Vulcain::Renderer::_collectInputLatencies() {
+    if(_getPastPresentationTiming) {
+        _collectPresentTimings();
+        return;
+    }
+
+    //
+    auto now = std::chrono::steady_clock::now();
+    for(size_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; frame++) {
+        auto &input = _frameInputs[frame];
+        if(input == std::chrono::steady_clock::time_point{} || !_isFrameComplete(frame)) continue;
+
+        //
+        _reportInputLatency(input, now);
+        input = {};
+    }
+}
+
+// frames never displayed are never reported, so inputs of presents older than a reported one are dropped
+void Vulcain::Renderer::_collectPresentTimings() {
+    if(_presentedInputs.empty()) return;
+
+    //
+    uint32_t count = 0;
+    auto result = _getPastPresentationTiming(*_device, *_swapchain, &count, nullptr);
+    if(result != VK_SUCCESS || !count) return;
+
+    std::vector<VkPastPresentationTimingGOOGLE> timings(count);
+    result = _getPastPresentationTiming(*_device, *_swapchain, &count, timings.data());
+    if(result != VK_SUCCESS && result != VK_INCOMPLETE) return;
+    timings.resize(count);
+
+    std::sort(timings.begin(), timings.end(), [](const VkPastPresentationTimingGOOGLE& a, const VkPastPresentationTimingGOOGLE& b) {
+        return a.presentID < b.presentID;
+    });
+
+    //
+    for(const auto &timing : timings) {
+        while(!_presentedInputs.empty() && _presentedInputs.front().first < timing.presentID) _presentedInputs.pop_front();
+        if(_presentedInputs.empty() || _presentedInputs.front().first != timing.presentID) continue;
+
+        //
+        auto presented = std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(timing.actualPresentTime))
+        );
+        _reportInputLatency(_presentedInputs.front().second, presented);
+        _presentedInputs.pop_front();
+    }
+}
+
+void Vulcain::Renderer::_reportInputLatency(std::chrono::steady_clock::time_point input, std::chrono::steady_clock::time_point observed) {
+    auto ms = std::chrono::duration<double, std::milli>(observed - input).count();
+
+    _inputLatency.samples++;
+    _inputLatency.lastMs = ms;
+    _inputLatency.averageMs += (ms - _inputLatency.averageMs) / _inputLatency.samples;
+    _inputLatency.maxMs = std::max(_inputLatency.maxMs, ms);
+}
+
+void Vulcain::Renderer::_resetImagesTracking() {
+    _imagesInFlight.assign(_target->imagesCount(), VK_NULL_HANDLE);
+    _imageValues.assign(_target->imagesCount(), 0);
+    _nextImage = 0;
+}
+
+void Vulcain::Renderer::_waitFrame(size_t frame) {
+    auto wasComplete = _isFrameComplete(frame);
+
+    //
+    if(_timeline) {
+        _timeline->wait(_frameValues[frame]);
+    } else {
+        vkWaitForFences(*_device, 1, &_inFlightFences[frame], VK_TRUE, UINT64_MAX);
+    }
+
+    // completion observed as it happens, rather than by the next poll
+    auto &input = _frameInputs[frame];
+    if(wasComplete || _getPastPresentationTiming || input == std::chrono::steady_clock::time_point{}) return;
+    _reportInputLatency(input, std::chrono::steady_clock::now());
+    input = {};
+}
+
+void Vulcain::Renderer::_waitImage(uint32_t imageIndex) {
+    if(_timeline) {
+        // already reached most of the time, which avoids a blocking call
+        if(!_timeline->isReached(_imageValues[imageIndex])) _timeline->wait(_imageValues[imageIndex]);
+    } else if (_imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+        vkWaitForFences(*_device, 1, &_imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    }
 }
 
 void Vulcain::Renderer::_createSyncObjects() {
     _imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
     _renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    _inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    _imagesInFlight.resize(_cmdPool->views()->imagesCount(), VK_NULL_HANDLE);
+    _inFlightFences.resize(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    _frameValues.resize(MAX_FRAMES_IN_FLIGHT, 0);
+    _resetImagesTracking();
 
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -151,6 +419,9 @@ void Vulcain::Renderer::_createSyncObjects() {
         auto r2 = vkCreateSemaphore(*_device, &semaphoreInfo, nullptr, &_renderFinishedSemaphores[i]);
         assert(r2 == VK_SUCCESS);
         
+        // the timeline replaces fences
+        if(_timeline) continue;
+
         auto r3 = vkCreateFence    (*_device, &fenceInfo,     nullptr, &_inFlightFences[i]);
         assert(r3 == VK_SUCCESS);
     }
@@ -158,11 +429,19 @@ void Vulcain::Renderer::_createSyncObjects() {
 
 void Vulcain::Renderer::_regenerateSwapChain() {
     //
-    _window->waitUntilSwapchainIsLegal();
+    if(_window) _window->waitUntilSwapchainIsLegal();
 
     // wait
     vkDeviceWaitIdle(*_device);
 
+    // account frames completed meanwhile, before their slots are reused; the next swapchain only reports its own presents
+    _collectInputLatencies();
+    _presentedInputs.clear();
+
     // regenerate chain
-    _swapchain->regenerate();
+    _target->regenerate();
+
+    // images count and frames in flight may have changed, and nothing is in flight anymore
+    _resetImagesTracking();
+    _currentFrame = 0;
 }
\ No newline at end of file
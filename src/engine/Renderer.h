@@ -21,6 +21,16 @@
 
 #include "common/IDrawer.h"
 #include "CommandPool.hpp"
+#include "ComputeScheduler.hpp"
+#include "OffscreenTarget.hpp"
+#include "Swapchain.hpp"
+#include "Timeline.hpp"
+#include "common/FrameTimings.hpp"
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <memory>
 
 namespace Vulcain {
 
@@ -28,15 +38,47 @@ class Renderer : public IDrawer, public DeviceBound {
  public:
    using BeforeWaitingCurrentImageCallback = std::function<void(uint32_t)>;
 
-    Renderer(const CommandPool* pool, GlfwWindow* window, Vulcain::Swapchain* swapchain);
+    // frames are tracked by a timeline semaphore if "preferTimeline" and supported, by fences otherwise
+    Renderer(CommandPool* pool, GlfwWindow* window, Vulcain::Swapchain* swapchain, bool preferTimeline = true);
+
+    // headless : images of "target" are rendered into round-robin, nothing being presented nor any input sampled.
+    // "draw()" is then called by the application, eg. a fixed number of times
+    Renderer(CommandPool* pool, OffscreenTarget* target, bool preferTimeline = true);
+
     ~Renderer();
 
     void draw() final;
 
     void onBeforeWaitingCurrentImage(BeforeWaitingCurrentImageCallback cb);
 
+    // compute work submitted each frame ahead of graphics, see "ComputeScheduler"
+    void scheduleCompute(ComputeScheduler* scheduler);
+
+    // graphics queue counter, each frame signaling the next value; null if fences are used.
+    // Resources used by a frame can be reused once "timeline()->isReached(frameValue)"
+    const Timeline* timeline() const;
+
+    // waits for the GPU, then regenerates the target and its dependents with these settings
+    void applySettings(const RenderSettings& settings);
+
+    struct LatencyReport {
+        uint64_t samples = 0;
+        double lastMs = 0;
+        double averageMs = 0;
+        double maxMs = 0;
+    };
+
+    // from a window input event to the presentation of the first frame sampling it, as reported by VK_GOOGLE_display_timing on Linux and Android.
+    // Elsewhere, to the GPU completion of that frame : taken when its wait returns, or when a later draw finds it complete, which is an upper bound.
+    // Compositor and scan-out delays then come on top
+    const LatencyReport& inputLatency() const;
+    void resetInputLatency();
+
+    // CPU time of each "draw()" phase over recent frames, safe to read from another thread.
+    // GPU time is collected by the command pool's profiler if any, see "CommandPool::profile()"
+    const FrameTimings& timings() const;
+
  private:
-    static const int MAX_FRAMES_IN_FLIGHT = 2;
     size_t _currentFrame = 0;
 
     std::vector<VkSemaphore> _imageAvailableSemaphores;
@@ -44,19 +86,55 @@ class Renderer : public IDrawer, public DeviceBound {
     std::vector<VkFence> _inFlightFences;
     std::vector<VkFence> _imagesInFlight;
 
-    std::atomic<bool> _hasFramebufferResized;
+    // timeline backend, replacing fences : values signaled by the last submission of each frame and image
+    std::unique_ptr<Timeline> _timeline;
+    std::vector<uint64_t> _frameValues;
+    std::vector<uint64_t> _imageValues;
 
-    BeforeWaitingCurrentImageCallback _onBeforeWaitingCurrentImage;
+    std::atomic<bool> _hasFramebufferResized = false;
+
+    // latest input sampled by each frame still being processed, epoch if none
+    std::array<std::chrono::steady_clock::time_point, MAX_FRAMES_IN_FLIGHT> _frameInputs{};
+    std::chrono::steady_clock::time_point _sampledInput{};
+    LatencyReport _inputLatency;
+
+    // display timing backend : inputs of presents whose actual time is not known yet, by present ID
+    static constexpr size_t PENDING_PRESENTS_MAX = 64;
+    PFN_vkGetPastPresentationTimingGOOGLE _getPastPresentationTiming = nullptr;
+    std::deque<std::pair<uint32_t, std::chrono::steady_clock::time_point>> _presentedInputs;
+    uint32_t _presentID = 0;
 
-    const CommandPool* _cmdPool = nullptr;
+    FrameTimings _timings;
+    uint64_t _drawnFrames = 0;
+
+    BeforeWaitingCurrentImageCallback _onBeforeWaitingCurrentImage;
 
     // non-const
-    Swapchain* _swapchain = nullptr;
-    GlfwWindow* _window = nullptr;
+    CommandPool* _cmdPool = nullptr;
+    ComputeScheduler* _compute = nullptr;
+    IRenderTarget* _target = nullptr;
+    Swapchain* _swapchain = nullptr; // null if headless
+    GlfwWindow* _window = nullptr; // null if headless
+
+    // next offscreen image
+    uint32_t _nextImage = 0;
+
+    Renderer(CommandPool* pool, IRenderTarget* target, bool preferTimeline);
 
     void _createSyncObjects();
 
+    VkResult _acquire(uint32_t* imageIndex);
+
+    void _waitFrame(size_t frame);
+    void _waitImage(uint32_t imageIndex);
+    bool _isFrameComplete(size_t frame) const;
+
+    void _sampleInput(size_t frame);
+    void _collectInputLatencies();
+    void _collectPresentTimings();
+    void _reportInputLatency(std::chrono::steady_clock::time_point input, std::chrono::steady_clock::time_point observed);
 
+    void _resetImagesTracking();
 
     void _regenerateSwapChain();
 };
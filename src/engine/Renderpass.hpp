@@ -19,13 +19,13 @@
 
 #pragma once
 
-#include "Swapchain.hpp"
+#include "IRenderTarget.hpp"
 
 namespace Vulcain {
 
 class Renderpass : public DeviceBound, public IRegenerable {
  public:
-    Renderpass(Swapchain* swapchain) : DeviceBound(swapchain), IRegenerable(swapchain), _swapchain(swapchain) {
+    Renderpass(IRenderTarget* target) : DeviceBound(target), IRegenerable(target), _target(target) {
         //
         _colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         _colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
@@ -33,7 +33,7 @@ class Renderpass : public DeviceBound, public IRegenerable {
         _colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         _colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         _colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        _colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        _colorAttachment.finalLayout = target->finalLayout();
 
         _colorAttachmentRef.attachment = 0;
         _colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -63,8 +63,8 @@ class Renderpass : public DeviceBound, public IRegenerable {
 
     operator VkRenderPass() const { return _renderPass; }
 
-    const Swapchain* swapchain() const {
-        return _swapchain;
+    const IRenderTarget* target() const {
+        return _target;
     }
 
     ~Renderpass() {
@@ -78,12 +78,12 @@ class Renderpass : public DeviceBound, public IRegenerable {
     VkSubpassDependency _dependency{};
     VkRenderPassCreateInfo _renderPassInfo{};
 
-    const Swapchain* _swapchain = nullptr;
+    const IRenderTarget* _target = nullptr;
     VkRenderPass _renderPass;
 
     void _gen() final {
-        // update imageformat from recreated swapchain
-        _colorAttachment.format = _swapchain->imageFormat;
+        // update imageformat from recreated target
+        _colorAttachment.format = _target->imageFormat;
 
         // create
         auto result = vkCreateRenderPass(*_device, &_renderPassInfo, nullptr, &_renderPass);
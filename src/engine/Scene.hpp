@@ -0,0 +1,238 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "FrustumCuller.hpp"
+#include "common/ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <span>
+#include <vector>
+
+namespace Vulcain {
+
+// Transform hierarchy stored as structure of arrays, ordered by depth so that parents always come before their children.
+// "update()" then computes world matrices in a single pass over each depth level, levels in order, a level's nodes being spread over threads.
+// Nodes are stable handles; "indexOf()" gives their position in component arrays, which is also their index in uploaded matrices.
+class Scene {
+ public:
+    using Node = uint32_t;
+    static constexpr Node NO_PARENT = UINT32_MAX;
+    static constexpr uint32_t NODES_PER_TASK = 1024;
+
+    // "bounds" is a local space sphere (center, radius); "renderHandle" is free for the caller, eg. a mesh or material index
+    Node add(Node parent = NO_PARENT, const glm::vec3& position = glm::vec3(0), const glm::quat& rotation = glm::quat(1, 0, 0, 0), const glm::vec3& scale = glm::vec3(1), const glm::vec4& bounds = glm::vec4(0), uint32_t renderHandle = 0) {
+        auto node = static_cast<Node>(_indexOf.size());
+        auto level = parent == NO_PARENT ? 0 : _level[_indexOf[parent]] + 1;
+
+        // appending keeps depth ordering as long as no shallower node follows a deeper one
+        if(_node.size() && level < _level.back()) _isSorted = false;
+
+        //
+        _indexOf.push_back(static_cast<uint32_t>(_node.size()));
+        _node.push_back(node);
+        _parent.push_back(parent);
+        _level.push_back(level);
+        _position.push_back(position);
+        _rotation.push_back(rotation);
+        _scale.push_back(scale);
+        _localBounds.push_back(bounds);
+        _renderHandle.push_back(renderHandle);
+        _parentIndex.push_back(parent == NO_PARENT ? NO_PARENT : _indexOf[parent]);
+
+        // still ordered, node ends its level or starts a deeper one
+        if(_isSorted) {
+            if(level == _levelBegin.size() - 1) _levelBegin.push_back(_levelBegin.back());
+            _levelBegin.back()++;
+        }
+
+        //
+        return node;
+    }
+
+    void clear() {
+        *this = Scene();
+    }
+
+    void setPosition(Node node, const glm::vec3& position) { _position[_indexOf[node]] = position; }
+    void setRotation(Node node, const glm::quat& rotation) { _rotation[_indexOf[node]] = rotation; }
+    void setScale(Node node, const glm::vec3& scale) { _scale[_indexOf[node]] = scale; }
+    void setBounds(Node node, const glm::vec4& bounds) { _localBounds[_indexOf[node]] = bounds; }
+    void setRenderHandle(Node node, uint32_t renderHandle) { _renderHandle[_indexOf[node]] = renderHandle; }
+
+    uint32_t size() const {
+        return static_cast<uint32_t>(_node.size());
+    }
+
+    // position of the node in component arrays, as of last "update()"
+    uint32_t indexOf(Node node) const {
+        return _indexOf[node];
+    }
+
+    // computes world matrices and bounds. If "mapped" is given (eg. from "DynamicBuffer<glm::mat4>::map()"), matrices are also streamed into it :
+    // parents are read back from system memory, never from mapped memory which might be uncached
+    void update(ThreadPool* threads = nullptr, std::span<glm::mat4> mapped = {}) {
+        assert(mapped.empty() || mapped.size() >= _node.size());
+        if(!_isSorted) _sortByLevel();
+
+        //
+        _world.resize(_node.size());
+        _worldBounds.resize(_node.size());
+
+        //
+        for(size_t level = 0; level + 1 < _levelBegin.size(); level++) {
+            auto begin = _levelBegin[level];
+            auto end = _levelBegin[level + 1];
+            auto tasksCount = (end - begin + NODES_PER_TASK - 1) / NODES_PER_TASK;
+
+            auto updateTask = [this, begin, end, mapped](uint32_t task, uint32_t) {
+                auto taskBegin = begin + task * NODES_PER_TASK;
+                auto taskEnd = std::min(taskBegin + NODES_PER_TASK, end);
+                _updateRange(taskBegin, taskEnd, mapped);
+            };
+
+            if(threads) {
+                threads->parallelFor(tasksCount, updateTask);
+            } else {
+                for(uint32_t i = 0; i < tasksCount; i++) updateTask(i, 0);
+            }
+        }
+    }
+
+    //
+    // Components, in depth order
+    //
+
+    std::span<const glm::mat4> worldMatrices() const { return _world; }
+    std::span<const glm::vec4> worldBounds() const { return _worldBounds; }
+    std::span<const uint32_t> renderHandles() const { return _renderHandle; }
+    std::span<const Node> nodes() const { return _node; }
+
+    // feeds world bounds to a culler, so that its visible indices are component indices
+    void syncBounds(FrustumCuller& culler) const {
+        culler.reserve(size());
+        while(culler.size() < size()) culler.add(glm::vec3(0), 0);
+        for(uint32_t i = 0; i < size(); i++) {
+            culler.set(i, glm::vec3(_worldBounds[i]), _worldBounds[i].w);
+        }
+    }
+
+ private:
+    bool _isSorted = true;
+
+    // indexed by node
+    std::vector<uint32_t> _indexOf;
+
+    // components, indexed by position
+    std::vector<Node> _node;
+    std::vector<Node> _parent;
+    std::vector<uint32_t> _level;
+    std::vector<glm::vec3> _position;
+    std::vector<glm::quat> _rotation;
+    std::vector<glm::vec3> _scale;
+    std::vector<glm::vec4> _localBounds;
+    std::vector<uint32_t> _renderHandle;
+
+    // derived, indexed by position
+    std::vector<uint32_t> _parentIndex;
+    std::vector<glm::mat4> _world;
+    std::vector<glm::vec4> _worldBounds;
+
+    // first position of each level, plus end
+    std::vector<uint32_t> _levelBegin { 0 };
+
+    void _updateRange(uint32_t begin, uint32_t end, std::span<glm::mat4> mapped) {
+        for(auto i = begin; i < end; i++) {
+            // local TRS
+            auto local = glm::mat4_cast(_rotation[i]);
+            local[0] *= _scale[i].x;
+            local[1] *= _scale[i].y;
+            local[2] *= _scale[i].z;
+            local[3] = glm::vec4(_position[i], 1.f);
+
+            //
+            auto parent = _parentIndex[i];
+            auto &world = _world[i] = parent == NO_PARENT ? local : _world[parent] * local;
+            if(mapped.size()) mapped[i] = world;
+
+            // conservative under non-uniform scale
+            auto scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+            auto center = world * glm::vec4(glm::vec3(_localBounds[i]), 1.f);
+            _worldBounds[i] = glm::vec4(glm::vec3(center), _localBounds[i].w * scale);
+        }
+    }
+
+    // stable counting sort of every component by level
+    void _sortByLevel() {
+        uint32_t levelsCount = 0;
+        for(auto level : _level) levelsCount = std::max(levelsCount, level + 1);
+
+        //
+        _levelBegin.assign(levelsCount + 1, 0);
+        for(auto level : _level) _levelBegin[level + 1]++;
+        for(uint32_t l = 0; l < levelsCount; l++) _levelBegin[l + 1] += _levelBegin[l];
+
+        //
+        std::vector<uint32_t> newPosition(_node.size());
+        auto next = _levelBegin;
+        for(size_t i = 0; i < _node.size(); i++) {
+            newPosition[i] = next[_level[i]]++;
+        }
+
+        //
+        _permute(_node, newPosition);
+        _permute(_parent, newPosition);
+        _permute(_level, newPosition);
+        _permute(_position, newPosition);
+        _permute(_rotation, newPosition);
+        _permute(_scale, newPosition);
+        _permute(_localBounds, newPosition);
+        _permute(_renderHandle, newPosition);
+
+        //
+        for(uint32_t i = 0; i < _node.size(); i++) {
+            _indexOf[_node[i]] = i;
+        }
+
+        _isSorted = true;
+        _resolveParents();
+    }
+
+    void _resolveParents() {
+        _parentIndex.resize(_node.size());
+        for(size_t i = 0; i < _node.size(); i++) {
+            _parentIndex[i] = _parent[i] == NO_PARENT ? NO_PARENT : _indexOf[_parent[i]];
+        }
+    }
+
+    template<class T>
+    static void _permute(std::vector<T>& components, const std::vector<uint32_t>& newPosition) {
+        std::vector<T> sorted(components.size());
+        for(size_t i = 0; i < components.size(); i++) {
+            sorted[newPosition[i]] = components[i];
+        }
+        components = std::move(sorted);
+    }
+};
+
+} // namespace Vulcain
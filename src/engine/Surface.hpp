@@ -26,13 +26,9 @@ namespace Vulcain {
 
 class Surface {
  public:    
+    // whichever platform GLFW runs on, as long as the instance enabled the extensions it requires
     Surface(GlfwWindow* window, const Instance* instance) : _instance(instance), _window(window) {
-        VkWin32SurfaceCreateInfoKHR createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR;
-        createInfo.hwnd = _window->handle();
-        createInfo.hinstance = GetModuleHandle(nullptr);
-
-        auto result = vkCreateWin32SurfaceKHR(*_instance, &createInfo, nullptr, &_surface);
+        auto result = glfwCreateWindowSurface(*_instance, _window->handle(), nullptr, &_surface);
         assert(result == VK_SUCCESS);
     }
 
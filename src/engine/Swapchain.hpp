@@ -19,41 +19,32 @@
 
 #pragma once
 
-#include "Device.hpp"
-#include "common/IRegenerable.h"
+#include "IRenderTarget.hpp"
 
 namespace Vulcain {
 
-class Swapchain : public VkSwapchainCreateInfoKHR, public DeviceBound, public IRegenerator {
+class Swapchain : public IRenderTarget {
  public:
-    Swapchain(const Device* device) : VkSwapchainCreateInfoKHR{}, DeviceBound(device) {
+    Swapchain(const Device* device, const RenderSettings& settings = {}) : IRenderTarget(device, settings) {
         //
         auto const &swapChainSupport = _device->swapchainDetails();
         const auto swapSurfaceFormat = swapChainSupport.getSwapSurfaceFormat();
-        const auto presentMode = swapChainSupport.getSwapPresentMode();
-
-        // determine image count
-        auto imageCount = swapChainSupport.capabilities.minImageCount + 1;
-        if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-            imageCount = swapChainSupport.capabilities.maxImageCount;
-        }
-
-        this->sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        this->surface = *_device->surface();
-        this->minImageCount = imageCount;
         this->imageFormat = swapSurfaceFormat.format;
-        this->imageColorSpace = swapSurfaceFormat.colorSpace;
-        this->imageArrayLayers = 1;
-        this->imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-        this->preTransform = swapChainSupport.capabilities.currentTransform;
-        this->compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; // determine transparency behavior with other windows, here just disable any transparency
-        this->presentMode = presentMode;
-        this->clipped = VK_TRUE;
+
+        _createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        _createInfo.surface = *_device->surface();
+        _createInfo.imageFormat = swapSurfaceFormat.format;
+        _createInfo.imageColorSpace = swapSurfaceFormat.colorSpace;
+        _createInfo.imageArrayLayers = 1;
+        _createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        _createInfo.preTransform = swapChainSupport.capabilities.currentTransform;
+        _createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR; // determine transparency behavior with other windows, here just disable any transparency
+        _createInfo.clipped = VK_TRUE;
 
         // since both presentation and graphics queues are the same index...
-        this->imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        this->queueFamilyIndexCount = 0; // Optional
-        this->pQueueFamilyIndices = nullptr; // Optional
+        _createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        _createInfo.queueFamilyIndexCount = 0; // Optional
+        _createInfo.pQueueFamilyIndices = nullptr; // Optional
 
         //
         _gen();
@@ -61,38 +52,8 @@ class Swapchain : public VkSwapchainCreateInfoKHR, public DeviceBound, public IR
 
     operator VkSwapchainKHR() const { return _swapChain; }
 
-    auto imagesCount() const {
-        return _swapChainImages.size();
-    }
-
-    const std::vector<VkImage> images() const {
-        return _swapChainImages;
-    }
-
-    const Device* device() const {
-        return _device;
-    }
-
-    VkViewport defaultViewport() const {
-        VkViewport viewport{};
-
-        //
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = (float) this->imageExtent.width;
-        viewport.height = (float) this->imageExtent.height;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        //
-        return viewport;
-    }
-
-    VkRect2D defaultScissor() const {
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        scissor.extent = this->imageExtent;
-        return scissor;
+    VkImageLayout finalLayout() const final {
+        return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
     }
 
     ~Swapchain() {
@@ -101,23 +62,33 @@ class Swapchain : public VkSwapchainCreateInfoKHR, public DeviceBound, public IR
 
  private:
     VkSwapchainKHR _swapChain;
-    std::vector<VkImage> _swapChainImages;
+    VkSwapchainCreateInfoKHR _createInfo{};
 
     void _gen() final {
         // update extent
         auto const &swapChainSupport = _device->swapchainDetails();
         this->imageExtent = _device->surface()->window()->framebufferSize();
+        _createInfo.imageExtent = this->imageExtent;
+
+        // determine image count
+        auto const &capabilities = swapChainSupport.capabilities;
+        auto minImageCount = std::max(_settings.imageCount.value_or(capabilities.minImageCount + 1), capabilities.minImageCount);
+        if (capabilities.maxImageCount > 0 && minImageCount > capabilities.maxImageCount) {
+            minImageCount = capabilities.maxImageCount;
+        }
+        _createInfo.minImageCount = minImageCount;
+        _createInfo.presentMode = swapChainSupport.getSwapPresentMode(_settings.presentModes);
 
         // create swapchain...
-        auto result = vkCreateSwapchainKHR(*_device, this, nullptr, &_swapChain);
+        auto result = vkCreateSwapchainKHR(*_device, &_createInfo, nullptr, &_swapChain);
         assert(result == VK_SUCCESS);
 
         // get images
         unsigned int imageCount = 0;
         vkGetSwapchainImagesKHR(*_device, _swapChain, &imageCount, nullptr);
         assert(imageCount);
-        _swapChainImages.resize(imageCount);
-        vkGetSwapchainImagesKHR(*_device, _swapChain, &imageCount, _swapChainImages.data());
+        _images.resize(imageCount);
+        vkGetSwapchainImagesKHR(*_device, _swapChain, &imageCount, _images.data());
     }
 
     void _degen() final {
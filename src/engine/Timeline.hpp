@@ -0,0 +1,107 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "Device.hpp"
+
+namespace Vulcain {
+
+// Timeline semaphore (VK_KHR_timeline_semaphore) of a queue : each submission signals the next value of a single increasing counter,
+// so that completion of any past submission is known by comparing values, without fences nor blocking.
+class Timeline : public DeviceBound {
+ public:
+    static bool isSupported(const Device* device) {
+        return device->hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
+    explicit Timeline(const Device* device) : DeviceBound(device) {
+        assert(isSupported(device));
+
+        // extension entry points, whichever the loader
+        _getCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(*_device, "vkGetSemaphoreCounterValueKHR"));
+        _waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(*_device, "vkWaitSemaphoresKHR"));
+        assert(_getCounterValue && _waitSemaphores);
+
+        //
+        VkSemaphoreTypeCreateInfoKHR typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        auto result = vkCreateSemaphore(*_device, &semaphoreInfo, nullptr, &_semaphore);
+        assert(result == VK_SUCCESS);
+    }
+
+    ~Timeline() {
+        vkDestroySemaphore(*_device, _semaphore, nullptr);
+    }
+
+    operator VkSemaphore() const { return _semaphore; }
+
+    // value the next submission must signal
+    uint64_t advance() {
+        return ++_submitted;
+    }
+
+    // last value handed to a submission
+    uint64_t submittedValue() const {
+        return _submitted;
+    }
+
+    // polls the GPU progress, never blocks
+    uint64_t completedValue() const {
+        uint64_t value;
+        auto result = _getCounterValue(*_device, _semaphore, &value);
+        assert(result == VK_SUCCESS);
+        return value;
+    }
+
+    // whether resources used up to "value" can be reused or freed
+    bool isReached(uint64_t value) const {
+        return completedValue() >= value;
+    }
+
+    void wait(uint64_t value) const {
+        if(!value) return;
+
+        VkSemaphoreWaitInfoKHR waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &_semaphore;
+        waitInfo.pValues = &value;
+
+        auto result = _waitSemaphores(*_device, &waitInfo, UINT64_MAX);
+        assert(result == VK_SUCCESS);
+    }
+
+ private:
+    VkSemaphore _semaphore;
+    uint64_t _submitted = 0;
+
+    PFN_vkGetSemaphoreCounterValueKHR _getCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR _waitSemaphores = nullptr;
+};
+
+} // namespace Vulcain
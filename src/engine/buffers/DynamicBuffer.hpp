@@ -0,0 +1,117 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <span>
+
+#include "IBuffer.hpp"
+
+namespace Vulcain {
+
+// Persistently mapped geometry, rewritten by the CPU every frame.
+// Each frame (usually, each swapchain image) owns its own slot, so writing a frame never stalls on the others;
+// a frame must only be written once its previous submission completed.
+template<class T, VkBufferUsageFlagBits q>
+class IDynamicBuffer : public DeviceBound {
+ public:
+    // exposes the same "buffer" and "vertexCount()" as static buffers, for use in record callbacks
+    class Slot : public IBuffer {
+     public:
+        const uint32_t capacity;
+
+        Slot(const DeviceBound* deviceBound, uint32_t capacity) : IBuffer(
+            deviceBound,
+            sizeof(T) * capacity,
+            q,
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        ), capacity(capacity) {}
+
+        auto vertexCount() const {
+            return _count;
+        }
+
+     private:
+        friend class IDynamicBuffer;
+        uint32_t _count = 0;
+    };
+
+    IDynamicBuffer(const DeviceBound* deviceBound, size_t framesCount, uint32_t initialCapacity = 64) : DeviceBound(deviceBound) {
+        assert(framesCount && initialCapacity);
+        _retired.resize(framesCount);
+        _slots.reserve(framesCount);
+        for(size_t i = 0; i < framesCount; i++) {
+            _slots.push_back(std::make_unique<Slot>(this, initialCapacity));
+        }
+    }
+
+    const Slot& operator[](size_t frame) const {
+        return *_slots[frame];
+    }
+
+    auto framesCount() const {
+        return _slots.size();
+    }
+
+    // writable view of "count" elements of this frame, to be filled in place.
+    // "grew" is set if the slot had to be reallocated : commands referencing its previous "buffer" must then be re-recorded
+    std::span<T> map(size_t frame, uint32_t count, bool* grew = nullptr) {
+        // previous buffer of this slot is no longer in use by now
+        _retired[frame].reset();
+
+        //
+        auto &slot = _slots[frame];
+        auto mustGrow = count > slot->capacity;
+        if(grew) *grew = mustGrow;
+
+        // grow geometrically, keeping the previous buffer alive until next time this frame is written
+        if(mustGrow) {
+            auto capacity = std::max(count, slot->capacity * 2);
+            _retired[frame] = std::move(slot);
+            slot = std::make_unique<Slot>(this, capacity);
+        }
+
+        //
+        slot->_count = count;
+        return { static_cast<T*>(slot->mappedData()), count };
+    }
+
+    // copies data into this frame's slot, returns true if the slot grew
+    bool write(size_t frame, std::span<const T> data) {
+        bool grew;
+        auto mapped = map(frame, static_cast<uint32_t>(data.size()), &grew);
+        memcpy(mapped.data(), data.data(), data.size_bytes());
+        return grew;
+    }
+
+ private:
+    std::vector<std::unique_ptr<Slot>> _slots;
+    std::vector<std::unique_ptr<Slot>> _retired;
+};
+
+template<class T>
+using DynamicBuffer = IDynamicBuffer<T, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT>;
+
+using DynamicIndexBuffer = IDynamicBuffer<uint16_t, VK_BUFFER_USAGE_INDEX_BUFFER_BIT>;
+
+} // namespace Vulcain
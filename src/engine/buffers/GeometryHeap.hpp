@@ -0,0 +1,141 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <optional>
+#include <span>
+
+#include "UploadQueue.hpp"
+#include "engine/helpers/FreeListAllocator.hpp"
+
+namespace Vulcain {
+
+// Packs many meshes into one vertex buffer and one index buffer, so that a frame binds them once
+// and only issues draws with offsets. Removing a mesh still in use by the GPU is up to the caller to avoid.
+template<class V>
+class GeometryHeap : public DeviceBound {
+ public:
+    using Index = uint32_t;
+    static constexpr VkIndexType INDEX_TYPE = VK_INDEX_TYPE_UINT32;
+
+    // handle to a mesh living in the heap, feeds vkCmdDrawIndexed directly
+    struct Mesh {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+
+        // as returned by "UploadQueue::enqueue()" for each region
+        std::shared_future<void> verticesUploaded;
+        std::shared_future<void> indicesUploaded;
+
+        // never blocks; drawing before then reads stale memory
+        bool isUploaded() const {
+            using namespace std::chrono_literals;
+            return verticesUploaded.wait_for(0s) == std::future_status::ready && indicesUploaded.wait_for(0s) == std::future_status::ready;
+        }
+    };
+
+    GeometryHeap(UploadQueue* uploads, uint32_t vertexCapacity, uint32_t indexCapacity) : 
+        DeviceBound(uploads),
+        _uploads(uploads),
+        _vertexRanges(vertexCapacity),
+        _indexRanges(indexCapacity),
+        // shared, since regions are uploaded from the transfer queue while others are being drawn
+        _vertices(this, sizeof(V) * vertexCapacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, 0, true),
+        _indices(this, sizeof(Index) * indexCapacity, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, 0, 0, true) {}
+
+    // stages mesh for upload on next "uploads->flush()"; indices are relative to the mesh's own vertices.
+    // Empty if vertices or indices are, or if the heap has not enough contiguous room left
+    std::optional<Mesh> add(std::span<const V> vertices, std::span<const Index> indices) {
+        if(vertices.empty() || indices.empty()) return std::nullopt;
+
+        //
+        auto vertexOffset = _vertexRanges.allocate(static_cast<uint32_t>(vertices.size()));
+        if(!vertexOffset) return std::nullopt;
+
+        auto firstIndex = _indexRanges.allocate(static_cast<uint32_t>(indices.size()));
+        if(!firstIndex) {
+            _vertexRanges.free(*vertexOffset, static_cast<uint32_t>(vertices.size()));
+            return std::nullopt;
+        }
+
+        //
+        Mesh mesh;
+        mesh.firstIndex = *firstIndex;
+        mesh.indexCount = static_cast<uint32_t>(indices.size());
+        mesh.vertexOffset = static_cast<int32_t>(*vertexOffset);
+        mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+
+        //
+        mesh.verticesUploaded = _uploads->enqueue(vertices.data(), vertices.size_bytes(), _vertices, sizeof(V) * mesh.vertexOffset);
+        mesh.indicesUploaded = _uploads->enqueue(indices.data(), indices.size_bytes(), _indices, sizeof(Index) * mesh.firstIndex);
+
+        //
+        return mesh;
+    }
+
+    // give the mesh's ranges back to the heap
+    void remove(const Mesh& mesh) {
+        _vertexRanges.free(static_cast<uint32_t>(mesh.vertexOffset), mesh.vertexCount);
+        _indexRanges.free(mesh.firstIndex, mesh.indexCount);
+    }
+
+    // once per command buffer, for every mesh of this heap
+    void bind(VkCommandBuffer cmdBuf) const {
+        VkBuffer vertexBuffers[] = {_vertices.buffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(cmdBuf, _indices.buffer, 0, INDEX_TYPE);
+    }
+
+    static void draw(VkCommandBuffer cmdBuf, const Mesh& mesh, uint32_t instanceCount = 1, uint32_t firstInstance = 0) {
+        vkCmdDrawIndexed(cmdBuf, mesh.indexCount, instanceCount, mesh.firstIndex, mesh.vertexOffset, firstInstance);
+    }
+
+    VkBuffer vertexBuffer() const {
+        return _vertices.buffer;
+    }
+
+    VkBuffer indexBuffer() const {
+        return _indices.buffer;
+    }
+
+    const FreeListAllocator& vertexRanges() const {
+        return _vertexRanges;
+    }
+
+    const FreeListAllocator& indexRanges() const {
+        return _indexRanges;
+    }
+
+ private:
+    UploadQueue* _uploads = nullptr;
+
+    FreeListAllocator _vertexRanges;
+    FreeListAllocator _indexRanges;
+
+    IBuffer _vertices;
+    IBuffer _indices;
+};
+
+} // namespace Vulcain
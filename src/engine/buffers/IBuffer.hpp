@@ -21,125 +21,106 @@
 
 #include "engine/Device.hpp"
 
+#include <optional>
+#include <span>
+
 namespace Vulcain {
 
 class IBuffer : public DeviceBound {
  public:
     const VkDeviceSize bufferSize;
+    const VkSharingMode sharingMode;
 
     VkBuffer buffer;
-    VkDeviceMemory bufferMemory;
+    VmaAllocation allocation;
 
-    IBuffer duplicate(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
-        return IBuffer(this, this->bufferSize, usage, properties);
+    IBuffer duplicate(VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags requiredProperties = 0) {
+        return IBuffer(this, this->bufferSize, usage, memoryUsage, requiredProperties);
     }
 
-    IBuffer(const DeviceBound* deviceBound, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) : DeviceBound(deviceBound), bufferSize(size) {
+    // "shareAcrossQueues" avoids ownership transfers, at the cost of a possibly slower access on some hardware
+    IBuffer(const DeviceBound* deviceBound, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VkMemoryPropertyFlags requiredProperties = 0, VmaAllocationCreateFlags allocationFlags = 0, bool shareAcrossQueues = false) : 
+        DeviceBound(deviceBound), 
+        bufferSize(size),
+        sharingMode(_sharingMode(shareAcrossQueues)) {
         //
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
-        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.sharingMode = sharingMode;
 
         //
-        auto error = vkCreateBuffer(*_device, &bufferInfo, nullptr, &buffer);
-        assert(!error);
+        if(sharingMode == VK_SHARING_MODE_CONCURRENT) {
+            auto &families = _device->queueFamilies();
+            bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+            bufferInfo.pQueueFamilyIndices = families.data();
+        }
+
+        // memory type is picked by VMA from the intended usage, and sub-allocated from a shared block
+        VmaAllocationCreateInfo allocInfo{};
+        allocInfo.usage = memoryUsage;
+        allocInfo.requiredFlags = requiredProperties;
+        allocInfo.flags = allocationFlags;
 
         //
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(*_device, buffer, &memRequirements);
-        
-        //
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = _device->findMemoryType(memRequirements.memoryTypeBits, properties);
-        
-        //
-        error = vkAllocateMemory(*_device, &allocInfo, nullptr, &bufferMemory);
+        auto error = vmaCreateBuffer(_device->allocator(), &bufferInfo, &allocInfo, &buffer, &allocation, &_allocationInfo);
         assert(!error);
-
-        //
-        vkBindBufferMemory(*_device, buffer, bufferMemory, 0);
     }
 
-    void copyBuffer(const CommandPool* pool, IBuffer& dstBuffer) {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = *pool;
-        allocInfo.commandBufferCount = 1;
-
-        VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(*_device, &allocInfo, &commandBuffer);
-
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-        vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-            VkBufferCopy copyRegion{};
-            copyRegion.size = bufferSize;
-            vkCmdCopyBuffer(commandBuffer, buffer, dstBuffer.buffer, 1, &copyRegion);
-
-        vkEndCommandBuffer(commandBuffer);
-
-        VkSubmitInfo submitInfo{};
-        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submitInfo.commandBufferCount = 1;
-        submitInfo.pCommandBuffers = &commandBuffer;
-
-        vkQueueSubmit(_device->queue(), 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(_device->queue());
-
-        vkFreeCommandBuffers(*_device, *pool, 1, &commandBuffer);
+    // only available if created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+    void* mappedData() const {
+        return _allocationInfo.pMappedData;
     }
 
     ~IBuffer() {
-        vkDestroyBuffer(*_device, buffer, nullptr);
-        vkFreeMemory(*_device, bufferMemory, nullptr);
+        vmaDestroyBuffer(_device->allocator(), buffer, allocation);
+    }
+
+ private:
+    VmaAllocationInfo _allocationInfo{};
+
+    // concurrent sharing requires at least 2 distinct families
+    VkSharingMode _sharingMode(bool shareAcrossQueues) const {
+        if(shareAcrossQueues && _device->queueFamilies().size() > 1) return VK_SHARING_MODE_CONCURRENT;
+        return VK_SHARING_MODE_EXCLUSIVE;
     }
 };
 
 template<typename T>
 class IVerticeBuffer : public IBuffer {
  public:
-    IVerticeBuffer(const DeviceBound* deviceBound, T vertices, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) : IBuffer(
+    using Element = typename T::value_type;
+
+    IVerticeBuffer(const DeviceBound* deviceBound, std::span<const Element> vertices, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage) : IBuffer(
             deviceBound, 
-            _getBufferSize(vertices), 
+            vertices.size_bytes(), 
             usage,
-            properties
-        ), _vertices(vertices) { }
+            memoryUsage
+        ), _vertexCount(static_cast<uint32_t>(vertices.size())) { }
 
     auto vertexCount() const {
-        return static_cast<uint32_t>(_vertices.size());
+        return _vertexCount;
     }
 
-    T& vertices() {
-        return _vertices;
+    bool hasCPUCopy() const {
+        return _vertices.has_value();
+    }
+
+    // only available if the CPU copy was explicitly kept at construction
+    const T& vertices() const {
+        assert(hasCPUCopy());
+        return *_vertices;
     }
  
  protected:
-    void _mapVerticesToMemory(IBuffer& buffer) {
-        _mapVerticesToMemory(buffer.bufferMemory);
+    void _keepCPUCopy(T&& vertices) {
+        _vertices = std::move(vertices);
     }
 
  private:
-    T _vertices;
-
-    static auto _getBufferSize(T vertices) {
-        return sizeof(vertices[0]) * vertices.size();
-    }
-
-    void _mapVerticesToMemory(VkDeviceMemory memory) {
-        //
-        void* data;
-        vkMapMemory(*_device, memory, 0, this->bufferSize, 0, &data);
-        memcpy(data, _vertices.data(), (size_t) this->bufferSize);
-        vkUnmapMemory(*_device, memory);
-    }
+    const uint32_t _vertexCount;
+    std::optional<T> _vertices;
 };
 
 } // namespace Vulcain
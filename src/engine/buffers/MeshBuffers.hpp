@@ -0,0 +1,76 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "StaticBuffer.hpp"
+#include "engine/helpers/MeshOptimizer.hpp"
+
+#include <memory>
+#include <variant>
+
+namespace Vulcain {
+
+// GPU copy of an "OptimizedMesh", keeping the index width "MeshOptimizer" picked
+template<class V>
+class MeshBuffers {
+ public:
+    // takes the mesh's vertices and indices over; staged right away, copied on next "uploads->flush()"
+    MeshBuffers(UploadQueue* uploads, OptimizedMesh<V>&& mesh) : _vertices(uploads, std::move(mesh.vertices)) {
+        std::visit([this, uploads](auto &&indices) {
+            using I = typename std::decay_t<decltype(indices)>::value_type;
+            _indexType = indexTypeOf<I>();
+            _indexCount = static_cast<uint32_t>(indices.size());
+            _indices = std::make_unique<TStaticIndexBuffer<I>>(uploads, std::move(indices));
+        }, mesh.indices);
+    }
+
+    const StaticBuffer<V>& vertices() const {
+        return _vertices;
+    }
+
+    VkBuffer indexBuffer() const {
+        return std::visit([](auto const &indices) { return indices->buffer; }, _indices);
+    }
+
+    VkIndexType indexType() const {
+        return _indexType;
+    }
+
+    uint32_t indexCount() const {
+        return _indexCount;
+    }
+
+    // binds vertices at binding 0 and indices at their own width
+    void bind(VkCommandBuffer cmdBuf) const {
+        VkBuffer vertexBuffers[] = {_vertices.buffer};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
+        vkCmdBindIndexBuffer(cmdBuf, indexBuffer(), 0, _indexType);
+    }
+
+ private:
+    StaticBuffer<V> _vertices;
+    std::variant<std::unique_ptr<TStaticIndexBuffer<uint16_t>>, std::unique_ptr<TStaticIndexBuffer<uint32_t>>> _indices;
+    VkIndexType _indexType = VK_INDEX_TYPE_UINT16;
+    uint32_t _indexCount = 0;
+};
+
+} // namespace Vulcain
@@ -0,0 +1,133 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "VertexLayout.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <array>
+
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace Vulcain {
+
+// components normalized by the GPU : [-1, 1] for snorm, [0, 1] for unorm
+struct Snorm16x2 { int16_t x, y; };
+struct Snorm16x4 { int16_t x, y, z, w; };
+struct Unorm8x4 { uint8_t r, g, b, a; };
+
+// unit vector folded onto an octahedron, decoded in shaders with :
+//   vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+//   if (n.z < 0) n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+//   n = normalize(n);
+struct Octahedral : Snorm16x2 {};
+
+template<> struct VertexFormat<Snorm16x2>  { static constexpr VkFormat value = VK_FORMAT_R16G16_SNORM; };
+template<> struct VertexFormat<Snorm16x4>  { static constexpr VkFormat value = VK_FORMAT_R16G16B16A16_SNORM; };
+template<> struct VertexFormat<Unorm8x4>   { static constexpr VkFormat value = VK_FORMAT_R8G8B8A8_UNORM; };
+template<> struct VertexFormat<Octahedral> { static constexpr VkFormat value = VK_FORMAT_R16G16_SNORM; };
+
+namespace Packing {
+
+inline int16_t snorm16(float v) {
+    return static_cast<int16_t>(roundf(std::clamp(v, -1.f, 1.f) * 32767.f));
+}
+
+inline uint8_t unorm8(float v) {
+    return static_cast<uint8_t>(roundf(std::clamp(v, 0.f, 1.f) * 255.f));
+}
+
+inline Unorm8x4 unorm8x4(const glm::vec4& v) {
+    return { unorm8(v.x), unorm8(v.y), unorm8(v.z), unorm8(v.w) };
+}
+
+inline Unorm8x4 unorm8x4(const glm::vec3& v) {
+    return unorm8x4(glm::vec4(v, 1.f));
+}
+
+inline Octahedral octahedral(const glm::vec3& n) {
+    auto l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    if(l1 == 0.f) return { snorm16(0.f), snorm16(0.f) };
+
+    //
+    auto x = n.x / l1;
+    auto y = n.y / l1;
+
+    // lower hemisphere is folded over the diagonals
+    if(n.z < 0.f) {
+        auto fx = (1.f - fabsf(y)) * (x >= 0.f ? 1.f : -1.f);
+        auto fy = (1.f - fabsf(x)) * (y >= 0.f ? 1.f : -1.f);
+        x = fx;
+        y = fy;
+    }
+
+    return { snorm16(x), snorm16(y) };
+}
+
+} // namespace Packing
+
+// maps positions within bounds to snorm16, the model matrix being premultiplied by "dequantization()"
+class PositionQuantizer {
+ public:
+    PositionQuantizer(const glm::vec3& min, const glm::vec3& max) :
+        _center((min + max) * .5f),
+        _halfExtent(glm::max((max - min) * .5f, glm::vec3(1e-8f))) {}
+
+    Snorm16x4 encode(const glm::vec3& position) const {
+        auto n = (position - _center) / _halfExtent;
+        return { Packing::snorm16(n.x), Packing::snorm16(n.y), Packing::snorm16(n.z), Packing::snorm16(1.f) };
+    }
+
+    // from [-1, 1] back to mesh space
+    glm::mat4 dequantization() const {
+        return glm::scale(glm::translate(glm::mat4(1.f), _center), _halfExtent);
+    }
+
+ private:
+    glm::vec3 _center;
+    glm::vec3 _halfExtent;
+};
+
+// 16 bytes, against 36 for float position, normal and color
+struct PackedVertex {
+    Snorm16x4 pos;
+    Octahedral normal;
+    Unorm8x4 color;
+
+    static VkVertexInputBindingDescription getBindingDescription() {
+        return VertexLayout::bindingOf<PackedVertex>();
+    }
+
+    static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions() {
+        return {
+            vertexAttribute<decltype(pos)>(0, offsetof(PackedVertex, pos)),
+            vertexAttribute<decltype(normal)>(1, offsetof(PackedVertex, normal)),
+            vertexAttribute<decltype(color)>(2, offsetof(PackedVertex, color))
+        };
+    }
+};
+
+static_assert(sizeof(PackedVertex) == 16);
+
+} // namespace Vulcain
@@ -19,36 +19,78 @@
 
 #pragma once
 
-#include "IBuffer.hpp"
+#include "UploadQueue.hpp"
+
+#include <ranges>
 
 namespace Vulcain {
 
 template<class T, VkBufferUsageFlagBits q>
-class IStaticBuffer : public IVerticeBuffer<const T> {
+class IStaticBuffer : public IVerticeBuffer<T> {
  public:
-    IStaticBuffer(const CommandPool* pool, const T vertices) : IVerticeBuffer<const T>(
-        pool, 
-        vertices, 
+    using Element = typename IVerticeBuffer<T>::Element;
+
+    // does not block : data is staged right away, and copied to GPU memory on next "uploads->flush()".
+    // Accepts any contiguous range (std::span, std::vector...) without copying it; only staged data is kept.
+    template<class R> requires std::ranges::contiguous_range<R> && std::same_as<std::ranges::range_value_t<R>, Element>
+    IStaticBuffer(UploadQueue* uploads, const R& vertices, bool keepCPUCopy = false) : IVerticeBuffer<T>(
+        uploads, 
+        std::span<const Element>(vertices), 
         VK_BUFFER_USAGE_TRANSFER_DST_BIT | q, 
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+        VMA_MEMORY_USAGE_GPU_ONLY
     ) {
-        // create staging buffer
-        auto staging = IBuffer::duplicate(
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        );
+        _upload(uploads, vertices);
+        if(keepCPUCopy) this->_keepCPUCopy(T(std::ranges::begin(vertices), std::ranges::end(vertices)));
+    }
 
-        // map vertice to staging
-        IVerticeBuffer<const T>::_mapVerticesToMemory(staging);
+    // takes ownership of vertices, which are freed once staged unless "keepCPUCopy" is set for later readback
+    IStaticBuffer(UploadQueue* uploads, T&& vertices, bool keepCPUCopy = false) : IVerticeBuffer<T>(
+        uploads, 
+        std::span<const Element>(vertices), 
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | q, 
+        VMA_MEMORY_USAGE_GPU_ONLY
+    ) {
+        _upload(uploads, vertices);
+        
+        //
+        if(keepCPUCopy) {
+            this->_keepCPUCopy(std::move(vertices));
+        } else {
+            T().swap(vertices);
+        }
+    }
 
-        // copy staging to GPU memory
-        staging.copyBuffer(pool, *this);
+    // ready once the flushed batch holding this buffer's copy completed
+    const std::shared_future<void>& uploaded() const {
+        return _uploaded;
+    }
+
+ private:
+    std::shared_future<void> _uploaded;
+
+    void _upload(UploadQueue* uploads, std::span<const Element> vertices) {
+        _uploaded = uploads->enqueue(
+            vertices.data(), 
+            vertices.size_bytes(), 
+            *this
+        );
     }
 };
 
 template<class T>
 using StaticBuffer = IStaticBuffer<std::vector<T>, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT>;
 
-using StaticIndexBuffer = IStaticBuffer<std::vector<uint16_t>, VK_BUFFER_USAGE_INDEX_BUFFER_BIT>;
+template<class I>
+using TStaticIndexBuffer = IStaticBuffer<std::vector<I>, VK_BUFFER_USAGE_INDEX_BUFFER_BIT>;
+
+using StaticIndexBuffer = TStaticIndexBuffer<uint16_t>;
+using StaticIndexBuffer32 = TStaticIndexBuffer<uint32_t>;
+
+// as expected by vkCmdBindIndexBuffer()
+template<class I>
+constexpr VkIndexType indexTypeOf() {
+    static_assert(std::same_as<I, uint16_t> || std::same_as<I, uint32_t>, "unsupported index type");
+    return std::same_as<I, uint16_t> ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+}
 
 } // namespace Vulcain
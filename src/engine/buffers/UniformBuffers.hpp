@@ -22,49 +22,161 @@
 #include "IBuffer.hpp"
 #include "engine/DescriptorPools.hpp"
 
+#include <memory>
+
 namespace Vulcain {
 
 template<class T>
 class UniformBuffers : private std::vector<IBuffer>, public DeviceBound, public IRegenerable {
  public:
-    UniformBuffers(DescriptorPools* descrPools) : DeviceBound(descrPools), IRegenerable(descrPools), _swapchain(descrPools->swapchain()) {
+    // if "objectsPerImage" is set, a single ring buffer is sliced per image and per object, 
+    // and slices are meant to be bound as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC with "dynamicOffset()".
+    // if "isShared" is set, shaders read a single device buffer whatever the image, which "recordCopyToShared()"
+    // fills from the image's own copy : commands binding it do not depend on the image anymore
+    UniformBuffers(DescriptorPools* descrPools, uint32_t objectsPerImage = 0, bool isShared = false) : 
+        DeviceBound(descrPools), 
+        IRegenerable(descrPools), 
+        _target(descrPools->target()), 
+        _objectsPerImage(objectsPerImage),
+        _isShared(isShared),
+        _stride(_alignedStride(descrPools)) {
         _gen();
     }
 
+    bool isShared() const {
+        return _isShared;
+    }
+
+    bool isRing() const {
+        return _objectsPerImage;
+    }
+
+    VkDescriptorType descriptorType() const {
+        return isRing() ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    }
+
+    // buffer read by shaders
     VkBuffer buffer(uint32_t currentImage) const {
-        return (*this)[currentImage].buffer;
+        if(_isShared) return _shared->buffer;
+        return isRing() ? this->front().buffer : (*this)[currentImage].buffer;
+    }
+
+    // offset of the slice to pass to vkCmdBindDescriptorSets, only meaningful in ring mode; independent of the image if shared
+    uint32_t dynamicOffset(uint32_t currentImage, uint32_t objectIndex = 0) const {
+        assert(isRing() && objectIndex < _objectsPerImage);
+        if(_isShared) return static_cast<uint32_t>(objectIndex * _stride);
+        return _imageOffset(currentImage, objectIndex);
     }
 
-    void mapToMemory(uint32_t currentImage, const T& ubo) {
-        auto &buffer = (*this)[currentImage];
-        auto memory = buffer.bufferMemory;
+    // buffers are persistently mapped, so updating is only a copy
+    void mapToMemory(uint32_t currentImage, const T& ubo, uint32_t objectIndex = 0) {
+        void* data = isRing() ? 
+            static_cast<char*>(this->front().mappedData()) + _imageOffset(currentImage, objectIndex) : 
+            (*this)[currentImage].mappedData();
 
         //
-        void* data;
-        vkMapMemory(*_device, memory, 0, sizeof(ubo), 0, &data);
-            memcpy(data, &ubo, sizeof(ubo));
-        vkUnmapMemory(*_device, memory);
+        memcpy(data, &ubo, sizeof(ubo));
+    }
+
+    // to be recorded outside of render passes, before any draw reading uniforms
+    void recordCopyToShared(VkCommandBuffer commandBuffer, uint32_t currentImage) const {
+        assert(_isShared);
+
+        // previous draws are done reading
+        auto toTransfer = _sharedBarrier(VK_ACCESS_UNIFORM_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+        vkCmdPipelineBarrier(commandBuffer, 
+            UNIFORMS_READING_STAGES, VK_PIPELINE_STAGE_TRANSFER_BIT, 
+            0, 0, nullptr, 1, &toTransfer, 0, nullptr
+        );
+
+        //
+        VkBufferCopy region{};
+        region.srcOffset = isRing() ? _imageOffset(currentImage, 0) : 0;
+        region.dstOffset = 0;
+        region.size = _shared->bufferSize;
+
+        auto &source = isRing() ? this->front() : (*this)[currentImage];
+        vkCmdCopyBuffer(commandBuffer, source.buffer, _shared->buffer, 1, &region);
+
+        //
+        auto toShaders = _sharedBarrier(VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_UNIFORM_READ_BIT);
+        vkCmdPipelineBarrier(commandBuffer, 
+            VK_PIPELINE_STAGE_TRANSFER_BIT, UNIFORMS_READING_STAGES, 
+            0, 0, nullptr, 1, &toShaders, 0, nullptr
+        );
     }
 
  private:
-    const Swapchain* _swapchain = nullptr;
+    static constexpr VkPipelineStageFlags UNIFORMS_READING_STAGES = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    const IRenderTarget* _target = nullptr;
+    const uint32_t _objectsPerImage = 0;
+    const bool _isShared = false;
+    const VkDeviceSize _stride = 0;
+    std::unique_ptr<IBuffer> _shared;
+
+    uint32_t _imageOffset(uint32_t currentImage, uint32_t objectIndex) const {
+        return static_cast<uint32_t>((currentImage * _objectsPerImage + objectIndex) * _stride);
+    }
+
+    VkBufferMemoryBarrier _sharedBarrier(VkAccessFlags srcAccess, VkAccessFlags dstAccess) const {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = _shared->buffer;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        return barrier;
+    }
+
+    static VkDeviceSize _alignedStride(const DescriptorPools* descrPools) {
+        auto alignment = descrPools->target()->device()->properties().limits.minUniformBufferOffsetAlignment;
+        if(!alignment) return sizeof(T);
+        return (sizeof(T) + alignment - 1) & ~(alignment - 1);
+    }
+
+    void _emplaceMapped(VkDeviceSize bufferSize) {
+        this->emplace_back(
+            this, 
+            bufferSize,
+            _isShared ? VK_BUFFER_USAGE_TRANSFER_SRC_BIT : VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
+            VMA_MEMORY_USAGE_CPU_TO_GPU,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT
+        );
+    }
    
     void _gen() final {
-        VkDeviceSize bufferSize = sizeof(T);
-        this->reserve(_swapchain->imagesCount());
-
-        for(int i = 0; i < _swapchain->imagesCount(); i++) {
-            this->emplace_back(
-                this, 
-                bufferSize,
-                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        // what a single image needs
+        if(_isShared) {
+            _shared = std::make_unique<IBuffer>(
+                this,
+                isRing() ? _stride * _objectsPerImage : sizeof(T),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                VMA_MEMORY_USAGE_GPU_ONLY
             );
         }
+
+        // one slice per object, for each image
+        if(isRing()) {
+            this->reserve(1);
+            _emplaceMapped(_stride * _objectsPerImage * _target->imagesCount());
+            return;
+        }
+
+        //
+        this->reserve(_target->imagesCount());
+        for(size_t i = 0; i < _target->imagesCount(); i++) {
+            _emplaceMapped(sizeof(T));
+        }
     }
     
     void _degen() final {
         this->clear();
+        _shared.reset();
     }
 };
 
@@ -0,0 +1,318 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <list>
+
+#include "IBuffer.hpp"
+#include "engine/helpers/QueueOwnership.hpp"
+
+namespace Vulcain {
+
+// Gathers staging copies and submits them as a single batch, without ever waiting on a queue.
+// Copies run on the dedicated transfer queue if the device has one, then exclusive buffers are handed over to the main queue.
+// "enqueue()" can be called from any thread; "flush()" and "poll()" must be called from the thread submitting to the device queues.
+class UploadQueue : public DeviceBound {
+ public:
+    using OnUploadedCallback = std::function<void()>;
+
+    UploadQueue(const Device* device) : DeviceBound(device) {
+        _transferPool = _createCommandPool(_device->transferQueueIndex());
+        if(_transfersOwnership()) {
+            _acquirePool = _createCommandPool(_device->queueIndex());
+        }
+    }
+
+    ~UploadQueue() {
+        waitIdle();
+        vkDestroyCommandPool(*_device, _transferPool, nullptr);
+        if(_acquirePool) vkDestroyCommandPool(*_device, _acquirePool, nullptr);
+    }
+
+    // copies data into a staging buffer right away; GPU copy into "dst" happens on next "flush()"
+    std::shared_future<void> enqueue(const void* data, VkDeviceSize size, const IBuffer& dst, VkDeviceSize dstOffset = 0, OnUploadedCallback onUploaded = {}) {
+        //
+        Upload upload {
+            std::make_unique<IBuffer>(this, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY, 0, VMA_ALLOCATION_CREATE_MAPPED_BIT),
+            dst.buffer,
+            dstOffset,
+            dst.sharingMode == VK_SHARING_MODE_EXCLUSIVE
+        };
+        upload.onUploaded = std::move(onUploaded);
+        memcpy(upload.staging->mappedData(), data, (size_t) size);
+
+        //
+        auto future = upload.promise.get_future().share();
+
+        //
+        std::lock_guard lock(_pendingMutex);
+        _pending.push_back(std::move(upload));
+        return future;
+    }
+
+    // submits every pending copy at once, signaling a fence on completion
+    void flush() {
+        //
+        std::vector<Upload> uploads;
+        {
+            std::lock_guard lock(_pendingMutex);
+            uploads.swap(_pending);
+        }
+        if(uploads.empty()) return;
+
+        //
+        auto &batch = _inFlight.emplace_back();
+        batch.uploads = std::move(uploads);
+
+        //
+        auto transferFamily = static_cast<uint32_t>(_device->transferQueueIndex());
+        auto graphicsFamily = static_cast<uint32_t>(_device->queueIndex());
+        std::vector<VkBufferMemoryBarrier> releases;
+        std::vector<VkBufferMemoryBarrier> acquires;
+
+        //
+        batch.transferCommands = _beginCommands(_transferPool);
+
+            for(auto &upload : batch.uploads) {
+                //
+                VkBufferCopy copyRegion{};
+                copyRegion.dstOffset = upload.dstOffset;
+                copyRegion.size = upload.staging->bufferSize;
+                vkCmdCopyBuffer(batch.transferCommands, upload.staging->buffer, upload.dst, 1, &copyRegion);
+
+                //
+                if(!_transfersOwnership() || !upload.isExclusive) continue;
+                releases.push_back(QueueOwnership::release(
+                    upload.dst, upload.dstOffset, copyRegion.size, transferFamily, graphicsFamily, VK_ACCESS_TRANSFER_WRITE_BIT
+                ));
+                acquires.push_back(QueueOwnership::acquire(
+                    upload.dst, upload.dstOffset, copyRegion.size, transferFamily, graphicsFamily, VK_ACCESS_MEMORY_READ_BIT
+                ));
+            }
+
+            // same queue : make copies visible to any later submission
+            if(!_transfersOwnership()) {
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+                vkCmdPipelineBarrier(
+                    batch.transferCommands, 
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, 
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 
+                    0, 
+                    1, &barrier, 
+                    0, nullptr, 
+                    0, nullptr
+                );
+            
+            // dedicated queue : release ownership to the main queue
+            } else if(releases.size()) {
+                vkCmdPipelineBarrier(
+                    batch.transferCommands, 
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, 
+                    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 
+                    0, 
+                    0, nullptr, 
+                    static_cast<uint32_t>(releases.size()), releases.data(), 
+                    0, nullptr
+                );
+            }
+
+        vkEndCommandBuffer(batch.transferCommands);
+
+        //
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        auto result = vkCreateFence(*_device, &fenceInfo, nullptr, &batch.fence);
+        assert(result == VK_SUCCESS);
+
+        //
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.transferCommands;
+
+        // single queue, done
+        if(!_transfersOwnership()) {
+            result = vkQueueSubmit(_device->queue(), 1, &submitInfo, batch.fence);
+            assert(result == VK_SUCCESS);
+            return;
+        }
+
+        // signal main queue once copies are done...
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        result = vkCreateSemaphore(*_device, &semaphoreInfo, nullptr, &batch.transferDone);
+        assert(result == VK_SUCCESS);
+
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &batch.transferDone;
+        result = vkQueueSubmit(_device->transferQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+        assert(result == VK_SUCCESS);
+
+        // ... which acquires ownership of exclusive buffers, and makes copies into concurrent ones (eg. "GeometryHeap") visible
+        batch.acquireCommands = _beginCommands(_acquirePool);
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            vkCmdPipelineBarrier(
+                batch.acquireCommands, 
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 
+                0, 
+                1, &barrier, 
+                static_cast<uint32_t>(acquires.size()), acquires.data(), 
+                0, nullptr
+            );
+        vkEndCommandBuffer(batch.acquireCommands);
+
+        //
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo acquireInfo{};
+        acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireInfo.waitSemaphoreCount = 1;
+        acquireInfo.pWaitSemaphores = &batch.transferDone;
+        acquireInfo.pWaitDstStageMask = &waitStage;
+        acquireInfo.commandBufferCount = 1;
+        acquireInfo.pCommandBuffers = &batch.acquireCommands;
+        result = vkQueueSubmit(_device->queue(), 1, &acquireInfo, batch.fence);
+        assert(result == VK_SUCCESS);
+    }
+
+    // releases staging memory of completed batches and resolves their uploads, never blocks
+    void poll() {
+        for(auto it = _inFlight.begin(); it != _inFlight.end();) {
+            if(vkGetFenceStatus(*_device, it->fence) != VK_SUCCESS) {
+                ++it;
+                continue;
+            }
+
+            //
+            _complete(*it);
+            it = _inFlight.erase(it);
+        }
+    }
+
+    // flushes, then blocks until every enqueued upload completed
+    void waitIdle() {
+        flush();
+
+        //
+        for(auto &batch : _inFlight) {
+            vkWaitForFences(*_device, 1, &batch.fence, VK_TRUE, UINT64_MAX);
+            _complete(batch);
+        }
+        _inFlight.clear();
+    }
+
+    // how many uploads are still waiting for flush, or GPU completion
+    size_t pendingCount() {
+        size_t count = 0;
+        for(const auto &batch : _inFlight) count += batch.uploads.size();
+
+        std::lock_guard lock(_pendingMutex);
+        return count + _pending.size();
+    }
+
+ private:
+    struct Upload {
+        std::unique_ptr<IBuffer> staging;
+        VkBuffer dst;
+        VkDeviceSize dstOffset = 0;
+        bool isExclusive = true;
+        std::promise<void> promise;
+        OnUploadedCallback onUploaded;
+    };
+
+    struct Batch {
+        VkCommandBuffer transferCommands = VK_NULL_HANDLE;
+        VkCommandBuffer acquireCommands = VK_NULL_HANDLE;
+        VkSemaphore transferDone = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        std::vector<Upload> uploads;
+    };
+
+    VkCommandPool _transferPool = VK_NULL_HANDLE;
+    VkCommandPool _acquirePool = VK_NULL_HANDLE;
+
+    std::mutex _pendingMutex;
+    std::vector<Upload> _pending;
+    std::list<Batch> _inFlight;
+
+    bool _transfersOwnership() const {
+        return _device->transferQueueIndex() != _device->queueIndex();
+    }
+
+    void _complete(Batch &batch) {
+        //
+        for(auto &upload : batch.uploads) {
+            upload.promise.set_value();
+            if(upload.onUploaded) upload.onUploaded();
+        }
+
+        //
+        vkFreeCommandBuffers(*_device, _transferPool, 1, &batch.transferCommands);
+        if(batch.acquireCommands) vkFreeCommandBuffers(*_device, _acquirePool, 1, &batch.acquireCommands);
+        if(batch.transferDone) vkDestroySemaphore(*_device, batch.transferDone, nullptr);
+        vkDestroyFence(*_device, batch.fence, nullptr);
+    }
+
+    VkCommandBuffer _beginCommands(VkCommandPool pool) {
+        //
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = pool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        auto result = vkAllocateCommandBuffers(*_device, &allocInfo, &commandBuffer);
+        assert(result == VK_SUCCESS);
+
+        //
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+        //
+        return commandBuffer;
+    }
+
+    VkCommandPool _createCommandPool(int queueFamilyIndex) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndex;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        VkCommandPool pool;
+        auto result = vkCreateCommandPool(*_device, &poolInfo, nullptr, &pool);
+        assert(result == VK_SUCCESS);
+        return pool;
+    }
+};
+
+} // namespace Vulcain
@@ -2,6 +2,8 @@
 
 #include "engine/common/Vulcain.h"
 
+#include "VertexLayout.hpp"
+
 #include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 
@@ -14,26 +16,14 @@ struct Vertex {
     glm::vec3 color;
 
     static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription{};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return bindingDescription;
+        return VertexLayout::bindingOf<Vertex>();
     }
 
     static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions{};
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-
-        return attributeDescriptions;
+        return {
+            vertexAttribute<decltype(pos)>(0, offsetof(Vertex, pos)),
+            vertexAttribute<decltype(color)>(1, offsetof(Vertex, color))
+        };
     }
 };
 
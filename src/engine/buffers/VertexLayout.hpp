@@ -0,0 +1,91 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "engine/common/Vulcain.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace Vulcain {
+
+// VkFormat a vertex field is read as, specialized for each supported field type
+template<class T>
+struct VertexFormat;
+
+template<> struct VertexFormat<float>     { static constexpr VkFormat value = VK_FORMAT_R32_SFLOAT; };
+template<> struct VertexFormat<glm::vec2> { static constexpr VkFormat value = VK_FORMAT_R32G32_SFLOAT; };
+template<> struct VertexFormat<glm::vec3> { static constexpr VkFormat value = VK_FORMAT_R32G32B32_SFLOAT; };
+template<> struct VertexFormat<glm::vec4> { static constexpr VkFormat value = VK_FORMAT_R32G32B32A32_SFLOAT; };
+
+// attribute description whose format is deduced from the field type, eg. "vertexAttribute<decltype(pos)>(0, offsetof(Vertex, pos))"
+template<class T>
+constexpr VkVertexInputAttributeDescription vertexAttribute(uint32_t location, uint32_t offset, uint32_t binding = 0) {
+    return { location, binding, VertexFormat<T>::value, offset };
+}
+
+// vertex input state of a pipeline, as described by a vertex type and optional per-instance data
+struct VertexLayout {
+    // per-instance data is read from this binding, as "DrawList" binds it
+    static constexpr uint32_t INSTANCE_BINDING = 1;
+
+    // per-vertex binding first, then per-instance one if any
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+
+    // "V" exposes static "getBindingDescription()" and "getAttributeDescriptions()".
+    // "I" is per-instance data exposing static "getAttributeDescriptions()", whose locations must follow those of "V"
+    template<class V, class I = void>
+    static VertexLayout of() {
+        auto attributes = V::getAttributeDescriptions();
+        VertexLayout layout {
+            { V::getBindingDescription() },
+            { std::begin(attributes), std::end(attributes) }
+        };
+
+        //
+        if constexpr(!std::is_void_v<I>) {
+            layout.bindings.push_back(instanceBindingOf<I>());
+            for(auto attribute : I::getAttributeDescriptions()) {
+                attribute.binding = INSTANCE_BINDING;
+                layout.attributes.push_back(attribute);
+            }
+        }
+
+        return layout;
+    }
+
+    template<class V>
+    static constexpr VkVertexInputBindingDescription bindingOf(uint32_t binding = 0) {
+        return { binding, sizeof(V), VK_VERTEX_INPUT_RATE_VERTEX };
+    }
+
+    template<class I>
+    static constexpr VkVertexInputBindingDescription instanceBindingOf() {
+        return { INSTANCE_BINDING, sizeof(I), VK_VERTEX_INPUT_RATE_INSTANCE };
+    }
+};
+
+} // namespace Vulcain
@@ -0,0 +1,221 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace Vulcain {
+
+// Per-frame CPU timings of "Renderer::draw()" phases, kept in a fixed ring of the most recent frames.
+// Written by the rendering thread only; readable from any thread without locks, records being overwritten meanwhile skipped (seqlock).
+class FrameTimings {
+ public:
+    enum Phase : size_t {
+        FRAME_WAIT, // previous use of the frame's resources
+        ACQUIRE,
+        BEFORE_IMAGE_WAIT_CALLBACK, // "onBeforeWaitingCurrentImage()"
+        IMAGE_WAIT, // image still used by another frame
+        SUBMIT,
+        PRESENT,
+        REGENERATE, // swapchain out of date, suboptimal or resized; the frame is not presented if it happened right after "ACQUIRE"
+        PHASES_COUNT
+    };
+
+    static constexpr std::array<const char*, PHASES_COUNT> PHASE_NAMES {
+        "frameWait", "acquire", "beforeImageWaitCallback", "imageWait", "submit", "present", "regenerate"
+    };
+
+    struct Record {
+        uint64_t frame = 0;
+        std::array<float, PHASES_COUNT> ms {};
+
+        float totalMs() const {
+            float total = 0;
+            for(auto phase : ms) total += phase;
+            return total;
+        }
+    };
+
+    struct Percentiles {
+        double p50 = 0;
+        double p95 = 0;
+        double p99 = 0;
+    };
+
+    // "capacity" is rounded up to a power of two
+    explicit FrameTimings(uint32_t capacity = 1024) {
+        uint32_t rounded = 1;
+        while(rounded < capacity) rounded <<= 1;
+        _mask = rounded - 1;
+        _slots = std::make_unique<Slot[]>(rounded);
+    }
+
+    uint32_t capacity() const {
+        return _mask + 1;
+    }
+
+    // rendering thread only
+    void push(const Record& record) {
+        auto index = _written.load(std::memory_order_relaxed);
+        auto &slot = _slots[index & _mask];
+
+        // odd while being written
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.frame.store(record.frame, std::memory_order_relaxed);
+        for(size_t p = 0; p < PHASES_COUNT; p++) {
+            slot.ms[p].store(record.ms[p], std::memory_order_relaxed);
+        }
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+        _written.store(index + 1, std::memory_order_release);
+    }
+
+    // records still in the ring, oldest first
+    std::vector<Record> snapshot() const {
+        auto written = _written.load(std::memory_order_acquire);
+        auto count = std::min<uint64_t>(written, capacity());
+
+        //
+        std::vector<Record> records;
+        records.reserve(count);
+        for(auto index = written - count; index < written; index++) {
+            auto &slot = _slots[index & _mask];
+            auto sequence = slot.sequence.load(std::memory_order_acquire);
+            if(sequence != 2 * index + 2) continue;
+
+            //
+            Record record;
+            record.frame = slot.frame.load(std::memory_order_relaxed);
+            for(size_t p = 0; p < PHASES_COUNT; p++) {
+                record.ms[p] = slot.ms[p].load(std::memory_order_relaxed);
+            }
+
+            // overwritten while reading
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+            records.push_back(record);
+        }
+
+        return records;
+    }
+
+    // over the records still in the ring
+    Percentiles percentiles(Phase phase) const {
+        auto records = snapshot();
+        std::vector<float> values(records.size());
+        std::transform(records.begin(), records.end(), values.begin(), [phase](const Record& record) { return record.ms[phase]; });
+        return _percentiles(values);
+    }
+
+    Percentiles totalPercentiles() const {
+        auto records = snapshot();
+        std::vector<float> values(records.size());
+        std::transform(records.begin(), records.end(), values.begin(), [](const Record& record) { return record.totalMs(); });
+        return _percentiles(values);
+    }
+
+    // one line per frame, in milliseconds
+    void dumpCsv(std::ostream& os) const {
+        os << "frame";
+        for(auto name : PHASE_NAMES) os << ',' << name;
+        os << ",total" << '\n';
+
+        //
+        for(auto const &record : snapshot()) {
+            os << record.frame;
+            for(auto ms : record.ms) os << ',' << ms;
+            os << ',' << record.totalMs() << '\n';
+        }
+    }
+
+    // percentiles per phase, then frames
+    void dumpJson(std::ostream& os) const {
+        auto records = snapshot();
+
+        //
+        auto writePercentiles = [&os](const char* name, std::vector<float> values, bool last) {
+            auto p = _percentiles(values);
+            os << "    \"" << name << "\": { \"p50\": " << p.p50 << ", \"p95\": " << p.p95 << ", \"p99\": " << p.p99 << " }" << (last ? "" : ",") << '\n';
+        };
+
+        os << "{" << '\n';
+        os << "  \"percentiles\": {" << '\n';
+            for(size_t p = 0; p < PHASES_COUNT; p++) {
+                std::vector<float> values;
+                for(auto const &record : records) values.push_back(record.ms[p]);
+                writePercentiles(PHASE_NAMES[p], std::move(values), false);
+            }
+            std::vector<float> totals;
+            for(auto const &record : records) totals.push_back(record.totalMs());
+            writePercentiles("total", std::move(totals), true);
+        os << "  }," << '\n';
+
+        //
+        os << "  \"frames\": [" << '\n';
+            for(size_t i = 0; i < records.size(); i++) {
+                auto const &record = records[i];
+                os << "    { \"frame\": " << record.frame;
+                for(size_t p = 0; p < PHASES_COUNT; p++) {
+                    os << ", \"" << PHASE_NAMES[p] << "\": " << record.ms[p];
+                }
+                os << ", \"total\": " << record.totalMs() << " }" << (i + 1 < records.size() ? "," : "") << '\n';
+            }
+        os << "  ]" << '\n';
+        os << "}" << '\n';
+    }
+
+ private:
+    struct Slot {
+        std::atomic<uint64_t> sequence = 0;
+        std::atomic<uint64_t> frame = 0;
+        std::array<std::atomic<float>, PHASES_COUNT> ms {};
+    };
+
+    uint32_t _mask;
+    std::unique_ptr<Slot[]> _slots;
+    std::atomic<uint64_t> _written = 0;
+
+    // nearest rank
+    static Percentiles _percentiles(std::vector<float>& values) {
+        if(values.empty()) return {};
+
+        //
+        auto rank = [&values](double percentile) {
+            auto index = static_cast<size_t>(percentile * (values.size() - 1) + .5);
+            std::nth_element(values.begin(), values.begin() + index, values.end());
+            return static_cast<double>(values[index]);
+        };
+
+        return { rank(.5), rank(.95), rank(.99) };
+    }
+};
+
+} // namespace Vulcain
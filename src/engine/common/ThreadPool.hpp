@@ -0,0 +1,134 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vulcain {
+
+// Fixed set of workers running batches of indexed tasks; a batch is awaited by its caller.
+// Not reentrant : a single thread is expected to submit batches.
+class ThreadPool {
+ public:
+    // "task" is called with the task index and the index of the worker running it, in [0, workersCount()[
+    using Task = std::function<void(uint32_t, uint32_t)>;
+
+    // with no threads, tasks run on the calling thread as worker 0
+    explicit ThreadPool(uint32_t threadsCount = std::thread::hardware_concurrency()) {
+        _threads.reserve(threadsCount);
+        for(uint32_t i = 0; i < threadsCount; i++) {
+            _threads.emplace_back(&ThreadPool::_work, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+
+        //
+        for(auto &thread : _threads) {
+            thread.join();
+        }
+    }
+
+    uint32_t workersCount() const {
+        return std::max<uint32_t>(1, static_cast<uint32_t>(_threads.size()));
+    }
+
+    // blocks until every task ran
+    void parallelFor(uint32_t tasksCount, const Task& task) {
+        if(_threads.empty() || tasksCount <= 1) {
+            for(uint32_t i = 0; i < tasksCount; i++) task(i, 0);
+            return;
+        }
+
+        //
+        {
+            std::lock_guard lock(_mutex);
+            _task = &task;
+            _tasksCount = tasksCount;
+            _nextTask = 0;
+            _idleWorkers = 0;
+            _batch++;
+        }
+        _wake.notify_all();
+
+        //
+        std::unique_lock lock(_mutex);
+        _done.wait(lock, [this] { return _idleWorkers == _threads.size(); });
+        _task = nullptr;
+    }
+
+ private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+
+    const Task* _task = nullptr;
+    uint32_t _tasksCount = 0;
+    std::atomic<uint32_t> _nextTask = 0;
+    size_t _idleWorkers = 0;
+    uint64_t _batch = 0;
+    bool _stopping = false;
+
+    void _work(uint32_t workerIndex) {
+        uint64_t doneBatch = 0;
+        while(true) {
+            const Task* task;
+            uint32_t tasksCount;
+            {
+                std::unique_lock lock(_mutex);
+                _wake.wait(lock, [this, doneBatch] { return _stopping || _batch != doneBatch; });
+                if(_stopping) return;
+                doneBatch = _batch;
+                task = _task;
+                tasksCount = _tasksCount;
+            }
+
+            // workers pick tasks until none are left
+            for(auto i = _nextTask++; i < tasksCount; i = _nextTask++) {
+                (*task)(i, workerIndex);
+            }
+
+            //
+            {
+                std::lock_guard lock(_mutex);
+                _idleWorkers++;
+            }
+            _done.notify_one();
+        }
+    }
+};
+
+} // namespace Vulcain
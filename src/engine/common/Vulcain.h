@@ -8,6 +8,9 @@
 
 namespace Vulcain {
 
+// upper bound of frames the CPU may prepare while the GPU still processes previous ones, see "RenderSettings::framesInFlight"
+static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+
 static VkApplicationInfo info(const char* appName, uint32_t version = VK_MAKE_VERSION(1, 0, 0)) {
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
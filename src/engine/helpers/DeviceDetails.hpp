@@ -21,6 +21,7 @@
 
 #include "engine/Surface.hpp"
 
+#include <algorithm>
 #include <map>
 
 namespace Vulcain {
@@ -40,10 +41,11 @@ struct SwapChainSupportDetails {
         return formats[0];
     }
 
-    VkPresentModeKHR getSwapPresentMode() const {
-        for (const auto& availablePresentMode : presentModes) {
-            if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                return availablePresentMode;
+    // first of "preferred" available, FIFO otherwise since it always is
+    VkPresentModeKHR getSwapPresentMode(const std::vector<VkPresentModeKHR>& preferred) const {
+        for (auto mode : preferred) {
+            if (std::find(presentModes.begin(), presentModes.end(), mode) != presentModes.end()) {
+                return mode;
             }
         }
 
@@ -53,9 +55,13 @@ struct SwapChainSupportDetails {
 
 struct PhysicalDeviceDetails {
     const VkPhysicalDevice pDevice;
-    const Surface* surface = nullptr;
+    const Instance* instance = nullptr;
+    const Surface* surface = nullptr; // null if headless, "swapchainDetails" being empty then
+    VkPhysicalDeviceProperties properties{};
     SwapChainSupportDetails swapchainDetails;
     int presentationAndGraphicsQueueIndex = 0;
+    int transferQueueIndex = -1; // dedicated, -1 if none
+    int computeQueueIndex = -1; // dedicated, -1 if none
     VkSampleCountFlags handledMaxSampling = VK_SAMPLE_COUNT_1_BIT;
 };
 
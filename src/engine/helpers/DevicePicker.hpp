@@ -28,20 +28,26 @@ namespace Vulcain {
 class DevicePicker {
  public:
     static Device getBestDevice(const Surface* surface) {
-        _mayRatePhysicalDevice(surface);
+        _mayRatePhysicalDevice(surface->instance(), surface);
+        return { &_getPreferedPhysicalDevice() };
+    };
+
+    // rendering into "OffscreenTarget" only, without presentation support nor swapchain extension
+    static Device getBestHeadlessDevice(const Instance* instance) {
+        _mayRatePhysicalDevice(instance, nullptr);
         return { &_getPreferedPhysicalDevice() };
     };
 
  private:
     static inline std::multimap<int, PhysicalDeviceDetails> _pDevicesCandidates;
 
-     static void _mayRatePhysicalDevice(const Surface* surface) {
+     static void _mayRatePhysicalDevice(const Instance* instance, const Surface* surface) {
         // no need to re-rate
         if(_pDevicesCandidates.size()) return;
         
         // find score for each physical device
-        for (auto const device : surface->instance()->getPhysicalDevices()) {
-            PhysicalDeviceDetails pDetails {device, surface};
+        for (auto const device : instance->getPhysicalDevices()) {
+            PhysicalDeviceDetails pDetails {device, instance, surface};
             
             auto score = _rateDeviceSuitability(pDetails, surface);
             if(!score) continue;
@@ -67,7 +73,7 @@ class DevicePicker {
         int score = 0;
 
         // check properties
-        VkPhysicalDeviceProperties deviceProperties;
+        auto &deviceProperties = details.properties;
         VkPhysicalDeviceFeatures deviceFeatures;
         vkGetPhysicalDeviceProperties(details.pDevice, &deviceProperties);
         vkGetPhysicalDeviceFeatures(details.pDevice, &deviceFeatures);
@@ -90,7 +96,7 @@ class DevicePicker {
         if(!_hasPotententQueue(details, surface)) return 0;
 
         // ensure device supports swapchain
-        if(!_supportsSwapchain(details, surface)) return 0;
+        if(surface && !_supportsSwapchain(details, surface)) return 0;
 
         //
         return score;
@@ -182,19 +188,44 @@ class DevicePicker {
             auto requiredQueueHandled = queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT;
             if (!requiredQueueHandled) continue;
             
-            // check if queue can do presentation
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(details.pDevice, i, *surface, &presentSupport);
+            // check if queue can do presentation, if any
+            VkBool32 presentSupport = !surface;
+            if(surface) vkGetPhysicalDeviceSurfaceSupportKHR(details.pDevice, i, *surface, &presentSupport);
             if (!presentSupport) continue;
 
             // set this potent queue
             details.presentationAndGraphicsQueueIndex = i;
+            
+            // look for optional side queues
+            _findDedicatedQueues(details, queueFamilies);
             return true;
         }
 
         // none acceptable found !
         return false;
     }
+
+    // families outside of the graphics one, so that uploads and compute work can overlap with rendering
+    static void _findDedicatedQueues(PhysicalDeviceDetails &details, const std::vector<VkQueueFamilyProperties> &queueFamilies) {
+        for (size_t i = 0; i < queueFamilies.size(); i++) {
+            auto flags = queueFamilies[i].queueFlags;
+            if(flags & VK_QUEUE_GRAPHICS_BIT) continue;
+
+            // async compute
+            if((flags & VK_QUEUE_COMPUTE_BIT) && details.computeQueueIndex < 0) {
+                details.computeQueueIndex = i;
+            }
+
+            // prefer transfer-only families (DMA engines)
+            if(!(flags & VK_QUEUE_TRANSFER_BIT)) continue;
+            auto isTransferOnly = !(flags & VK_QUEUE_COMPUTE_BIT);
+            auto hasTransferOnly = details.transferQueueIndex >= 0 && 
+                !(queueFamilies[details.transferQueueIndex].queueFlags & VK_QUEUE_COMPUTE_BIT);
+            if(details.transferQueueIndex < 0 || (isTransferOnly && !hasTransferOnly)) {
+                details.transferQueueIndex = i;
+            }
+        }
+    }
 };
 
 } // namespace Vulcain
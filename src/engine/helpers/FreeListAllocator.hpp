@@ -0,0 +1,122 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <map>
+#include <optional>
+
+namespace Vulcain {
+
+// Hands out ranges of a fixed capacity (in any unit), best fit, merging freed neighbours back together.
+class FreeListAllocator {
+ public:
+    explicit FreeListAllocator(uint32_t capacity) : _capacity(capacity), _freeSpace(capacity) {
+        _insertFree(0, capacity);
+    }
+
+    // offset of the range, if any free range is large enough
+    std::optional<uint32_t> allocate(uint32_t size) {
+        assert(size);
+
+        // smallest free range which fits
+        auto found = _freeBySize.lower_bound(size);
+        if(found == _freeBySize.end()) return std::nullopt;
+
+        //
+        auto [rangeSize, offset] = *found;
+        _eraseFree(offset, rangeSize);
+
+        // give back what remains
+        if(rangeSize > size) {
+            _insertFree(offset + size, rangeSize - size);
+        }
+
+        //
+        _freeSpace -= size;
+        return offset;
+    }
+
+    void free(uint32_t offset, uint32_t size) {
+        assert(size && offset + size <= _capacity);
+        _freeSpace += size;
+
+        // merge with next free range
+        auto next = _freeByOffset.find(offset + size);
+        if(next != _freeByOffset.end()) {
+            size += next->second;
+            _eraseFree(next->first, next->second);
+        }
+
+        // merge with previous free range
+        auto previous = _freeByOffset.lower_bound(offset);
+        if(previous != _freeByOffset.begin()) {
+            --previous;
+            if(previous->first + previous->second == offset) {
+                offset = previous->first;
+                size += previous->second;
+                _eraseFree(previous->first, previous->second);
+            }
+        }
+
+        //
+        _insertFree(offset, size);
+    }
+
+    uint32_t capacity() const {
+        return _capacity;
+    }
+
+    uint32_t freeSpace() const {
+        return _freeSpace;
+    }
+
+    // the largest allocation that can currently succeed
+    uint32_t largestFreeRange() const {
+        return _freeBySize.empty() ? 0 : _freeBySize.rbegin()->first;
+    }
+
+ private:
+    const uint32_t _capacity;
+    uint32_t _freeSpace;
+
+    std::map<uint32_t, uint32_t> _freeByOffset;
+    std::multimap<uint32_t, uint32_t> _freeBySize;
+
+    void _insertFree(uint32_t offset, uint32_t size) {
+        _freeByOffset.emplace(offset, size);
+        _freeBySize.emplace(size, offset);
+    }
+
+    void _eraseFree(uint32_t offset, uint32_t size) {
+        _freeByOffset.erase(offset);
+
+        auto [first, last] = _freeBySize.equal_range(size);
+        for(auto it = first; it != last; ++it) {
+            if(it->second != offset) continue;
+            _freeBySize.erase(it);
+            break;
+        }
+    }
+};
+
+} // namespace Vulcain
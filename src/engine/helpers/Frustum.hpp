@@ -0,0 +1,59 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace Vulcain {
+
+// planes pointing inwards, as (normal, distance)
+struct Frustum {
+    std::array<glm::vec4, 6> planes;
+
+    // for [0, 1] depth range
+    static Frustum fromViewProjection(const glm::mat4& m) {
+        auto row = [&m](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+        Frustum frustum {{
+            row(3) + row(0), row(3) - row(0), // left, right
+            row(3) + row(1), row(3) - row(1), // bottom, top
+            row(2),          row(3) - row(2)  // near, far
+        }};
+
+        //
+        for(auto &plane : frustum.planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // conservative : spheres crossing a plane are kept
+    bool intersects(const glm::vec3& center, float radius) const {
+        for(auto const &plane : planes) {
+            if(glm::dot(glm::vec3(plane), center) + plane.w <= -radius) return false;
+        }
+        return true;
+    }
+};
+
+} // namespace Vulcain
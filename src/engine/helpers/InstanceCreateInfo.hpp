@@ -58,6 +58,10 @@ class AvailableExtensions {
         }
     }
 
+    bool contains(const char* ext) const {
+        return _extensionsContains(ext);
+    }
+
     void assertAll(const std::vector<const char*> &extsToUse) const {
         for(auto const & requiredExt : extsToUse) {            
             //
@@ -84,7 +88,8 @@ class AvailableExtensions {
 
 class InstanceCreateInfo : public VkInstanceCreateInfo {
  public:
-    InstanceCreateInfo(const VkApplicationInfo * appInfo) : VkInstanceCreateInfo{} {
+    // "headless" instances skip surface extensions, so that GLFW needs neither to be initialized nor to find a display
+    InstanceCreateInfo(const VkApplicationInfo * appInfo, bool headless = false) : VkInstanceCreateInfo{}, _isHeadless(headless) {
         //
         assert(appInfo);
 
@@ -102,6 +107,13 @@ class InstanceCreateInfo : public VkInstanceCreateInfo {
         _bindRequiredExtensions();
     }
 
+    bool hasExtension(const char* name) const {
+        for(auto enabled : _required_exts) {
+            if(strcmp(enabled, name) == 0) return true;
+        }
+        return false;
+    }
+
     const VkDebugUtilsMessengerCreateInfoEXT* debugUtil() const {
         return _debugInfo;
     }
@@ -141,14 +153,20 @@ class InstanceCreateInfo : public VkInstanceCreateInfo {
         this->enabledLayerCount = WANTED_LAYERS.size();
     }   
     
+    // enabled only if available, see "hasExtension()"
+    static inline std::array<const char*, 1> OPTIONAL_EXTENSIONS {
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME // required by some device extensions on Vulkan 1.0, eg. VK_KHR_timeline_semaphore
+    };
+
     std::vector<const char*> _required_exts;
+    const bool _isHeadless;
     void _bindRequiredExtensions() {
         // check layout required ext
         AvailableExtensions available;
         available.assertAll(_required_exts);
 
         // check GLFW required ext
-        {
+        if(!_isHeadless) {
             // get the extensions required by glfw
             uint32_t glfwExtensionCount = 0;
             auto extsToUse = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -158,6 +176,11 @@ class InstanceCreateInfo : public VkInstanceCreateInfo {
             available.assertAllAndInsert(extsToUse, glfwExtensionCount, _required_exts);
         }
 
+        //
+        for(auto optional : OPTIONAL_EXTENSIONS) {
+            if(available.contains(optional)) _required_exts.push_back(optional);
+        }
+
         //
         this->enabledExtensionCount = _required_exts.size();
         this->ppEnabledExtensionNames = _required_exts.data();
@@ -0,0 +1,424 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include "engine/common/Vulcain.h"
+
+#include <assert.h>
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+namespace Vulcain {
+
+struct MeshStatistics {
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+    float acmr = 0.f; // average cache miss ratio : transformed vertices per triangle, 0.5 at best, 3 at worst
+    float atvr = 0.f; // average transformed vertex ratio : transformed vertices per vertex, 1 at best
+    float overfetch = 0.f; // fetched bytes per vertex byte, 1 at best
+
+    friend std::ostream& operator<<(std::ostream& os, const MeshStatistics& stats) {
+        return os << stats.vertexCount << " vertices, "
+                  << stats.triangleCount << " triangles, ACMR "
+                  << stats.acmr << ", ATVR "
+                  << stats.atvr << ", overfetch "
+                  << stats.overfetch;
+    }
+};
+
+template<class V>
+struct OptimizedMesh {
+    std::vector<V> vertices;
+    std::variant<std::vector<uint16_t>, std::vector<uint32_t>> indices;
+    MeshStatistics before;
+    MeshStatistics after;
+
+    bool hasCompactIndices() const {
+        return std::holds_alternative<std::vector<uint16_t>>(indices);
+    }
+
+    VkIndexType indexType() const {
+        return hasCompactIndices() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+};
+
+// Processing run on meshes before upload : removes duplicate vertices, reorders triangles for
+// the post-transform vertex cache then for overdraw, reorders vertices for fetch locality,
+// and picks the smallest index type able to address the result.
+class MeshOptimizer {
+ public:
+    using Position = std::array<float, 3>;
+
+    static constexpr uint32_t ANALYZED_CACHE_SIZE = 16;
+    static constexpr uint32_t FETCH_CACHE_LINE = 64;
+
+    // "positionOf" returns a Position from a vertex, used to sort triangle clusters against overdraw.
+    // Statistics of the mesh are given before and after, eg. to be printed by the caller
+    template<class V, class PositionOf>
+    static OptimizedMesh<V> optimize(std::span<const V> vertices, std::span<const uint32_t> indices, PositionOf positionOf) {
+        assert(indices.size() % 3 == 0);
+        OptimizedMesh<V> out;
+        out.before = analyze(indices, vertices.size(), sizeof(V));
+
+        // dedup
+        std::vector<uint32_t> remappedIndices(indices.begin(), indices.end());
+        std::vector<V> uniqueVertices;
+        remapDuplicates(vertices, remappedIndices, uniqueVertices);
+
+        // triangles order
+        optimizeVertexCache(remappedIndices, uniqueVertices.size());
+
+        std::vector<Position> positions;
+        positions.reserve(uniqueVertices.size());
+        for(const auto &vertex : uniqueVertices) positions.push_back(positionOf(vertex));
+        optimizeOverdraw(remappedIndices, positions);
+
+        // vertices order
+        out.vertices = optimizeVertexFetch(std::span<const V>(uniqueVertices), remappedIndices);
+        out.after = analyze(remappedIndices, out.vertices.size(), sizeof(V));
+
+        // narrowest indices
+        if(out.vertices.size() <= std::numeric_limits<uint16_t>::max() + size_t(1)) {
+            out.indices = std::vector<uint16_t>(remappedIndices.begin(), remappedIndices.end());
+        } else {
+            out.indices = std::move(remappedIndices);
+        }
+
+        return out;
+    }
+
+    // keeps a single copy of bitwise identical vertices, rewriting indices accordingly
+    template<class V>
+    static void remapDuplicates(std::span<const V> vertices, std::vector<uint32_t>& indices, std::vector<V>& uniqueVertices) {
+        static_assert(std::is_trivially_copyable_v<V>, "vertices are compared bytewise");
+
+        //
+        auto hash = [&vertices](uint32_t i) {
+            auto bytes = reinterpret_cast<const unsigned char*>(&vertices[i]);
+            size_t h = 14695981039346656037ull; // FNV-1a
+            for(size_t b = 0; b < sizeof(V); b++) {
+                h = (h ^ bytes[b]) * 1099511628211ull;
+            }
+            return h;
+        };
+        auto equals = [&vertices](uint32_t a, uint32_t b) {
+            return memcmp(&vertices[a], &vertices[b], sizeof(V)) == 0;
+        };
+
+        //
+        std::unordered_map<uint32_t, uint32_t, decltype(hash), decltype(equals)> firstSeen(vertices.size(), hash, equals);
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        uniqueVertices.clear();
+
+        //
+        for(auto &index : indices) {
+            if(remap[index] == UINT32_MAX) {
+                auto [found, inserted] = firstSeen.emplace(index, static_cast<uint32_t>(uniqueVertices.size()));
+                if(inserted) uniqueVertices.push_back(vertices[index]);
+                remap[index] = found->second;
+            }
+            index = remap[index];
+        }
+    }
+
+    // linear-speed vertex cache optimisation (Tom Forsyth)
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+        constexpr int CACHE_SIZE = 32;
+        auto triangleCount = indices.size() / 3;
+        if(!triangleCount) return;
+
+        // vertex -> triangles adjacency
+        std::vector<uint32_t> valence(vertexCount, 0);
+        for(auto index : indices) valence[index]++;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+        std::partial_sum(valence.begin(), valence.end(), adjacencyOffsets.begin() + 1);
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            auto fill = adjacencyOffsets;
+            for(size_t i = 0; i < indices.size(); i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        //
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++) {
+            vertexScores[v] = _forsythScore(-1, valence[v], CACHE_SIZE);
+        }
+
+        std::vector<float> triangleScores(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        for(size_t t = 0; t < triangleCount; t++) {
+            triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        }
+
+        //
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        std::vector<uint32_t> cache, nextCache;
+        cache.reserve(CACHE_SIZE + 3);
+        nextCache.reserve(CACHE_SIZE + 3);
+
+        size_t scanCursor = 0;
+        auto bestTriangle = std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin();
+
+        //
+        while(bestTriangle >= 0) {
+            // emit
+            emitted[bestTriangle] = true;
+            const uint32_t* tri = &indices[bestTriangle * 3];
+            output.insert(output.end(), tri, tri + 3);
+
+            // move its vertices on top of the LRU cache
+            nextCache.clear();
+            nextCache.insert(nextCache.end(), tri, tri + 3);
+            for(auto v : cache) {
+                if(v != tri[0] && v != tri[1] && v != tri[2]) nextCache.push_back(v);
+            }
+
+            // one less triangle to draw for those vertices
+            for(int c = 0; c < 3; c++) {
+                auto v = tri[c];
+                auto begin = adjacency.begin() + adjacencyOffsets[v];
+                auto end = begin + valence[v];
+                auto found = std::find(begin, end, static_cast<uint32_t>(bestTriangle));
+                std::iter_swap(found, end - 1);
+                valence[v]--;
+            }
+
+            // rescore vertices touched by the cache update, and their triangles
+            bestTriangle = -1;
+            float bestScore = -1.f;
+            for(size_t c = 0; c < nextCache.size(); c++) {
+                auto v = nextCache[c];
+                int position = c < CACHE_SIZE ? static_cast<int>(c) : -1;
+                cachePosition[v] = position;
+
+                auto score = _forsythScore(position, valence[v], CACHE_SIZE);
+                auto delta = score - vertexScores[v];
+                vertexScores[v] = score;
+
+                for(uint32_t a = adjacencyOffsets[v]; a < adjacencyOffsets[v] + valence[v]; a++) {
+                    auto t = adjacency[a];
+                    triangleScores[t] += delta;
+                    if(triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+
+            //
+            if(nextCache.size() > CACHE_SIZE) nextCache.resize(CACHE_SIZE);
+            std::swap(cache, nextCache);
+
+            // nothing adjacent to the cache, pick the next remaining triangle
+            if(bestTriangle < 0) {
+                while(scanCursor < triangleCount && emitted[scanCursor]) scanCursor++;
+                if(scanCursor < triangleCount) bestTriangle = scanCursor;
+            }
+        }
+
+        //
+        indices = std::move(output);
+    }
+
+    // sorts clusters of cache-friendly triangles so that outer-facing ones are drawn first
+    static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Position>& positions) {
+        auto triangleCount = indices.size() / 3;
+        if(!triangleCount) return;
+
+        // clusters start where the vertex cache would have been entirely flushed, so their order does not hurt its efficiency
+        std::vector<size_t> clusterStarts;
+        {
+            std::vector<uint32_t> fifo(ANALYZED_CACHE_SIZE, UINT32_MAX);
+            size_t fifoCursor = 0;
+            for(size_t t = 0; t < triangleCount; t++) {
+                int misses = 0;
+                for(int c = 0; c < 3; c++) {
+                    auto v = indices[t * 3 + c];
+                    if(std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+                    fifo[fifoCursor++ % ANALYZED_CACHE_SIZE] = v;
+                    misses++;
+                }
+                if(misses == 3 || t == 0) clusterStarts.push_back(t);
+            }
+        }
+
+        // mesh centroid
+        Position meshCentroid {0.f, 0.f, 0.f};
+        for(auto index : indices) {
+            for(int k = 0; k < 3; k++) meshCentroid[k] += positions[index][k];
+        }
+        for(int k = 0; k < 3; k++) meshCentroid[k] /= indices.size();
+
+        // score each cluster by how much its area-weighted normal points away from the mesh centroid
+        struct Cluster { size_t begin; size_t end; float score; };
+        std::vector<Cluster> clusters;
+        clusters.reserve(clusterStarts.size());
+        for(size_t c = 0; c < clusterStarts.size(); c++) {
+            Cluster cluster { clusterStarts[c], c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount, 0.f };
+
+            Position centroid {0.f, 0.f, 0.f};
+            Position normal {0.f, 0.f, 0.f};
+            float area = 0.f;
+            for(auto t = cluster.begin; t < cluster.end; t++) {
+                auto &p0 = positions[indices[t * 3]];
+                auto &p1 = positions[indices[t * 3 + 1]];
+                auto &p2 = positions[indices[t * 3 + 2]];
+                Position e1 {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+                Position e2 {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+                Position n {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                auto triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+                for(int k = 0; k < 3; k++) {
+                    centroid[k] += (p0[k] + p1[k] + p2[k]) / 3.f * triangleArea;
+                    normal[k] += n[k];
+                }
+                area += triangleArea;
+            }
+
+            //
+            if(area > 0.f) {
+                auto normalLength = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                for(int k = 0; k < 3; k++) {
+                    centroid[k] /= area;
+                    if(normalLength > 0.f) normal[k] /= normalLength;
+                    cluster.score += (centroid[k] - meshCentroid[k]) * normal[k];
+                }
+            }
+
+            clusters.push_back(cluster);
+        }
+
+        //
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+            return a.score > b.score;
+        });
+
+        //
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        for(const auto &cluster : clusters) {
+            output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+        }
+        indices = std::move(output);
+    }
+
+    // orders vertices by first use, dropping unreferenced ones
+    template<class V>
+    static std::vector<V> optimizeVertexFetch(std::span<const V> vertices, std::vector<uint32_t>& indices) {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<V> out;
+        out.reserve(vertices.size());
+
+        //
+        for(auto &index : indices) {
+            if(remap[index] == UINT32_MAX) {
+                remap[index] = static_cast<uint32_t>(out.size());
+                out.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+
+        return out;
+    }
+
+    // simulates a FIFO post-transform cache, and a direct mapped cache for vertex fetches
+    template<class I>
+    static MeshStatistics analyze(std::span<const I> indices, size_t vertexCount, size_t vertexSize) {
+        MeshStatistics stats;
+        stats.vertexCount = static_cast<uint32_t>(vertexCount);
+        stats.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if(!stats.triangleCount || !vertexCount) return stats;
+
+        //
+        constexpr size_t FETCH_CACHE_LINES = 512;
+        std::vector<uint32_t> fifo(ANALYZED_CACHE_SIZE, UINT32_MAX);
+        std::vector<size_t> lines(FETCH_CACHE_LINES, SIZE_MAX);
+        size_t fifoCursor = 0;
+        size_t transformed = 0;
+        size_t fetchedLines = 0;
+
+        //
+        for(auto index : indices) {
+            uint32_t v = index;
+            if(std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+            fifo[fifoCursor++ % ANALYZED_CACHE_SIZE] = v;
+            transformed++;
+
+            // fetch each line the vertex spans
+            auto firstLine = (v * vertexSize) / FETCH_CACHE_LINE;
+            auto lastLine = ((v + 1) * vertexSize - 1) / FETCH_CACHE_LINE;
+            for(auto line = firstLine; line <= lastLine; line++) {
+                auto &slot = lines[line % FETCH_CACHE_LINES];
+                if(slot == line) continue;
+                slot = line;
+                fetchedLines++;
+            }
+        }
+
+        //
+        stats.acmr = float(transformed) / stats.triangleCount;
+        stats.atvr = float(transformed) / vertexCount;
+        stats.overfetch = float(fetchedLines * FETCH_CACHE_LINE) / (vertexCount * vertexSize);
+        return stats;
+    }
+
+    static MeshStatistics analyze(const std::vector<uint32_t>& indices, size_t vertexCount, size_t vertexSize) {
+        return analyze(std::span<const uint32_t>(indices), vertexCount, vertexSize);
+    }
+
+ private:
+    static float _forsythScore(int cachePosition, uint32_t remainingValence, int cacheSize) {
+        if(!remainingValence) return -1.f;
+
+        //
+        float score = 0.f;
+        if(cachePosition >= 0) {
+            // the triangle just drawn : its vertices get a fixed score, not to favor them too much
+            if(cachePosition < 3) {
+                score = 0.75f;
+            } else {
+                auto scaler = 1.f / (cacheSize - 3);
+                score = powf(1.f - (cachePosition - 3) * scaler, 1.5f);
+            }
+        }
+
+        // boost vertices with few triangles left, so that lone triangles get drawn
+        score += 2.f * powf(static_cast<float>(remainingValence), -0.5f);
+        return score;
+    }
+};
+
+} // namespace Vulcain
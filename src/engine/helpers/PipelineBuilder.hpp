@@ -20,7 +20,7 @@
 #pragma once
 
 #include "engine/common/Vulcain.h"
-#include "engine/buffers/Vertex.hpp"
+#include "engine/buffers/VertexLayout.hpp"
 
 namespace Vulcain {
 
@@ -37,16 +37,15 @@ struct PipelineBuilder {
     VkPipelineDynamicStateCreateInfo dynamicState{};
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
 
-    PipelineBuilder() {
+    // "vertexLayout" must outlive the builder
+    explicit PipelineBuilder(const VertexLayout& vertexLayout) {
         //
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-            _bindingDescr = Vertex::getBindingDescription();
-            vertexInputInfo.vertexBindingDescriptionCount = 1;
-            vertexInputInfo.pVertexBindingDescriptions = &_bindingDescr; // Optional
+            vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexLayout.bindings.size());
+            vertexInputInfo.pVertexBindingDescriptions = vertexLayout.bindings.data(); // Optional
 
-            _attrDescr = Vertex::getAttributeDescriptions();
-            vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(_attrDescr.size());
-            vertexInputInfo.pVertexAttributeDescriptions = _attrDescr.data(); // Optional
+            vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexLayout.attributes.size());
+            vertexInputInfo.pVertexAttributeDescriptions = vertexLayout.attributes.data(); // Optional
 
         //
         inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -115,9 +114,6 @@ struct PipelineBuilder {
         VK_DYNAMIC_STATE_VIEWPORT,
         VK_DYNAMIC_STATE_SCISSOR
     };
-
-    VkVertexInputBindingDescription _bindingDescr;
-    std::array<VkVertexInputAttributeDescription, 2> _attrDescr;
 };
 
 } // namespace Vulcain
@@ -24,21 +24,48 @@
 #include "engine/DescriptorPools.hpp"
 #include "engine/Renderpass.hpp"
 #include "engine/Pipeline.hpp"
+#include "engine/ComputePipeline.hpp"
 
 namespace Vulcain {
 
 class PipelineFactory {
  public:
     PipelineFactory(const Renderpass* renderpass, DescriptorPools* descrPools) : 
-        _foundry(renderpass->swapchain()->device()), 
-        _renderpass(renderpass), 
-        _descrPool(descrPools) {}
+        _foundry(renderpass->target()->device()), 
+        _descrPool(descrPools), 
+        _renderpass(renderpass) {}
     
-    Pipeline create(const char* moduleName) {
+    // "V" is the vertex type fed to the shaders, eg. "Vertex" or "PackedVertex".
+    // "I", if any, is per-instance data read from "VertexLayout::INSTANCE_BINDING", eg. as fed by "DrawList"
+    template<class V = Vertex, class I = void>
+    Pipeline create(const char* moduleName, uint32_t dynamicObjectsCount = 0, bool sharedUniforms = false) {
         return Pipeline(
             _renderpass, 
             _descrPool, 
-            _foundry.modulesFromShaderName(moduleName) 
+            _foundry.modulesFromShaderName(moduleName),
+            dynamicObjectsCount,
+            VertexLayout::of<V, I>(),
+            sharedUniforms
+        );
+    }
+
+    // "P" is a generated "Pipelines::" tag, carrying shaders name and reflected vertex layout, eg. "create<Pipelines::basic>()"
+    template<class P, class I = void>
+    Pipeline create(uint32_t dynamicObjectsCount = 0, bool sharedUniforms = false) {
+        return create<typename P::Vertex, I>(P::name, dynamicObjectsCount, sharedUniforms);
+    }
+
+    // "P" is a generated "Pipelines::" tag of a compute shader, carrying its reflected storage buffers, push constants and workgroup size.
+    // "setsCount" descriptor sets are allocated, eg. one per frame
+    template<class P>
+    ComputePipeline createCompute(size_t setsCount) {
+        return ComputePipeline(
+            _renderpass->target()->device(),
+            _foundry.modulesFromShaderName(P::name),
+            P::storageBuffers,
+            P::pushConstantsSize,
+            P::workgroupSize,
+            setsCount
         );
     }
     
@@ -0,0 +1,57 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+#pragma once
+
+#include "engine/common/Vulcain.h"
+
+namespace Vulcain {
+
+// Exclusive resources moving between queue families need a matching release / acquire barrier pair,
+// recorded on the source queue then on the destination queue, ordered by a semaphore.
+namespace QueueOwnership {
+
+    static VkBufferMemoryBarrier _transfer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t srcFamily, uint32_t dstFamily) {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = srcFamily;
+        barrier.dstQueueFamilyIndex = dstFamily;
+        barrier.buffer = buffer;
+        barrier.offset = offset;
+        barrier.size = size;
+        return barrier;
+    }
+
+    // to be recorded on "srcFamily" queue, dstAccessMask is ignored
+    static VkBufferMemoryBarrier release(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t srcFamily, uint32_t dstFamily, VkAccessFlags srcAccess) {
+        auto barrier = _transfer(buffer, offset, size, srcFamily, dstFamily);
+        barrier.srcAccessMask = srcAccess;
+        return barrier;
+    }
+
+    // to be recorded on "dstFamily" queue, srcAccessMask is ignored
+    static VkBufferMemoryBarrier acquire(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, uint32_t srcFamily, uint32_t dstFamily, VkAccessFlags dstAccess) {
+        auto barrier = _transfer(buffer, offset, size, srcFamily, dstFamily);
+        barrier.dstAccessMask = dstAccess;
+        return barrier;
+    }
+
+}   // namespace QueueOwnership
+
+} // namespace Vulcain
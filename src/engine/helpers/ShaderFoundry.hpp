@@ -64,7 +64,8 @@ class ShaderFoundry : public DeviceBound {
  private:
     static inline std::map<std::string, VkShaderStageFlagBits> STAGE_FROM_EXT {
         { ".vert", VK_SHADER_STAGE_VERTEX_BIT },
-        { ".frag", VK_SHADER_STAGE_FRAGMENT_BIT }
+        { ".frag", VK_SHADER_STAGE_FRAGMENT_BIT },
+        { ".comp", VK_SHADER_STAGE_COMPUTE_BIT }
     };
 
     void _createShaderModules() {
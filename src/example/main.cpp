@@ -20,73 +20,193 @@
 #include "engine/common/Vulcain.h"
 
 #include "engine/Renderer.h"
+#include "engine/ComputeScheduler.hpp"
+#include "engine/CullingPass.hpp"
 #include "engine/helpers/PipelineFactory.hpp"
 #include "engine/helpers/DevicePicker.hpp"
 
-#include "engine/buffers/StaticBuffer.hpp"
+#include "engine/buffers/MeshBuffers.hpp"
 #include "engine/buffers/UniformBuffers.hpp"
-#include "engine/buffers/Vertex.hpp"
 
-
-int main() {
-    using namespace Vulcain;
-
-    #ifdef USES_VOLK
-    auto result = volkInitialize();
-    assert(result == VK_SUCCESS);
-    #endif
-    
-    GlfwWindow window;
-
-    auto appInfo = info("Hello Triangle");
-    InstanceCreateInfo createInfo(&appInfo);
-    Instance instance(&createInfo);
-    Surface surface(&window, &instance);
-    auto device = DevicePicker::getBestDevice(&surface);
-    
-    Swapchain swapchain(&device);
-
-    Renderpass renderpass(&swapchain);
-    DescriptorPools descrPools(&swapchain);
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Vulcain;
+
+static void report(const Renderer& renderer, const GpuProfiler& gpuProfiler, const ComputeScheduler* computeScheduler) {
+    auto const &latency = renderer.inputLatency();
+    std::cout << "input latency : " << latency.averageMs << " ms average, " << latency.maxMs << " ms max, over " << latency.samples << " samples" << std::endl;
+
+    auto frameTimes = renderer.timings().totalPercentiles();
+    std::cout << "frame CPU time : " << frameTimes.p50 << " ms p50, " << frameTimes.p95 << " ms p95, " << frameTimes.p99 << " ms p99" << std::endl;
+    std::cout << "frame GPU time, last collected :\n" << gpuProfiler << std::flush;
+    if(computeScheduler) {
+        std::cout << "compute " << (computeScheduler->isAsync() ? "on its own queue" : "along graphics") << " : " << computeScheduler->report() << std::endl;
+    }
+
+    // eg. to track stutter in CI, as JSON if the path ends so, CSV otherwise
+    if(auto dumpPath = getenv("VULCAIN_FRAME_TIMINGS")) {
+        std::ofstream dump(dumpPath, std::ofstream::trunc);
+        if(std::filesystem::path(dumpPath).extension() == ".json") {
+            renderer.timings().dumpJson(dump);
+        } else {
+            renderer.timings().dumpCsv(dump);
+        }
+    }
+}
+
+// draws a spinning quad into "target" images, with the renderer "makeRenderer" returns; "run" draws frames until done.
+// With "gpuCulling", the quad goes through "CullingPass", scheduled ahead of graphics by a "ComputeScheduler", and is drawn indirectly
+template<class MakeRenderer, class Run>
+static void drawQuad(IRenderTarget* target, UploadQueue* uploads, bool gpuCulling, MakeRenderer makeRenderer, Run run) {
+    Renderpass renderpass(target);
+    DescriptorPools descrPools(target);
 
     PipelineFactory plFactory(&renderpass, &descrPools);
-    auto basicPipeline = plFactory.create("basic");
+    auto basicPipeline = plFactory.create<Pipelines::basic>(0, true);
     
     ImageViews views(&renderpass);
-    CommandPool cmdPool(&views);
-
-    StaticBuffer<Vertex> vertexes(&cmdPool, {
+    GpuProfiler gpuProfiler(target->device());
+    // culled draws read the buffers of the frame in flight, so are recorded each frame
+    CommandPool cmdPool(&views, gpuCulling ? CommandPool::Mode::PerFrame : CommandPool::Mode::Shared);
+    cmdPool.profile(&gpuProfiler);
+
+    // goes through the same optimization pass as any loaded mesh would
+    using Vertex = Pipelines::basic::Vertex;
+    const std::vector<Vertex> vertices {
         {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
         {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
         {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
         {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}
-    });
-
-    StaticIndexBuffer indexes(&cmdPool, {
+    };
+    const std::vector<uint32_t> indices {
         0, 1, 2,
         2, 3, 0
+    };
+    auto optimized = MeshOptimizer::optimize(std::span<const Vertex>(vertices), std::span<const uint32_t>(indices), [](const Vertex& vertex) {
+        return MeshOptimizer::Position{vertex.inPosition.x, vertex.inPosition.y, 0.0f};
+    });
+    std::cout << "quad before optimization : " << optimized.before << '\n'
+              << "quad after optimization : " << optimized.after << std::endl;
+
+    MeshBuffers<Vertex> quad(uploads, std::move(optimized));
+
+    // send all staged geometry at once
+    uploads->flush();
+
+    // a slot per frame in flight, which compute of a frame writes while graphics of the previous one might still read its own
+    std::unique_ptr<CullingPass> culling;
+    std::unique_ptr<ComputeScheduler> computeScheduler;
+    size_t culledSlot = 0;
+    if(gpuCulling) {
+        culling = std::make_unique<CullingPass>(target->device(), &plFactory, MAX_FRAMES_IN_FLIGHT, 1);
+
+        CulledObject object;
+        object.model = glm::mat4(1.0f);
+        object.boundingSphere = glm::vec4(0.0f, 0.0f, 0.0f, 0.75f);
+        object.indexCount = quad.indexCount();
+        for(size_t slot = 0; slot < MAX_FRAMES_IN_FLIGHT; slot++) {
+            culling->updateObjects(slot, std::span<const CulledObject>(&object, 1));
+        }
+
+        // submitted by the renderer right before the frame's graphics commands are recorded, which draw from the same slot
+        computeScheduler = std::make_unique<ComputeScheduler>(target->device());
+        computeScheduler->record([&culling, &culledSlot, target](VkCommandBuffer cmdBuf, size_t frame) {
+            auto ubo = spinUBO(target->imageExtent);
+            culling->recordCulling(cmdBuf, frame, Frustum::fromViewProjection(ubo.proj * ubo.view));
+            culledSlot = frame;
+        });
+    }
+
+    // uniforms of the image are copied to those drawing commands read
+    cmdPool.recordPrologue([&basicPipeline](VkCommandBuffer cmdBuf, size_t imageIndex) {
+        basicPipeline.recordUniformsCopy(cmdBuf, imageIndex);
     });
 
-    cmdPool.record([&basicPipeline, &vertexes, &indexes](VkCommandBuffer cmdBuf, size_t cmdBufIndex) {
+    cmdPool.record([&basicPipeline, &quad, &culling, &culledSlot](VkCommandBuffer cmdBuf, size_t cmdBufIndex) {
         vkCmdBindPipeline(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, basicPipeline);
-        
-        VkBuffer vertexBuffers[] = {vertexes.buffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(cmdBuf, 0, 1, vertexBuffers, offsets);
-
-        vkCmdBindIndexBuffer(cmdBuf, indexes.buffer, 0, VK_INDEX_TYPE_UINT16);
+        quad.bind(cmdBuf);
 
         vkCmdBindDescriptorSets(cmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, basicPipeline.layout(), 0, 1, basicPipeline.descriptorSet(cmdBufIndex), 0, nullptr);
 
-        vkCmdDrawIndexed(cmdBuf, indexes.vertexCount(), 1, 0, 0, 0);
+        if(culling) {
+            culling->recordDraws(cmdBuf, culledSlot);
+        } else {
+            vkCmdDrawIndexed(cmdBuf, quad.indexCount(), 1, 0, 0, 0);
+        }
     });
 
-    Renderer renderer(&cmdPool, &window, &swapchain);
-    renderer.onBeforeWaitingCurrentImage([&basicPipeline](uint32_t currentImage) {
+    std::unique_ptr<Renderer> renderer = makeRenderer(&cmdPool);
+    if(computeScheduler) renderer->scheduleCompute(computeScheduler.get());
+    renderer->onBeforeWaitingCurrentImage([&basicPipeline, uploads](uint32_t currentImage) {
+        uploads->poll();
         basicPipeline.updateUniformBuffer(currentImage);
     });
 
-    window.pollEventsAndDraw();
+    run(*renderer);
+
+    //
+    report(*renderer, gpuProfiler, computeScheduler.get());
+}
+
+// fixed resolution and frame count, without any window nor display, eg. for benchmarks and CI on software drivers
+static int headless(uint64_t framesCount) {
+    auto appInfo = info("Hello Triangle, headless");
+    InstanceCreateInfo createInfo(&appInfo, true);
+    Instance instance(&createInfo);
+    auto device = DevicePicker::getBestHeadlessDevice(&instance);
+    UploadQueue uploads(&device);
+
+    OffscreenTarget target(&device, { 1920, 1080 }, RenderSettings::throughput());
+
+    drawQuad(&target, &uploads, true, [&target](CommandPool* cmdPool) {
+        return std::make_unique<Renderer>(cmdPool, &target);
+    }, [framesCount, &device](Renderer& renderer) {
+        auto start = std::chrono::steady_clock::now();
+        for(uint64_t frame = 0; frame < framesCount; frame++) {
+            renderer.draw();
+        }
+        vkDeviceWaitIdle(device);
+
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << framesCount << " frames in " << seconds << " s, " << framesCount / seconds << " FPS" << std::endl;
+    });
+
+    return 0;
+}
+
+int main() {
+    #ifdef USES_VOLK
+    auto result = volkInitialize();
+    assert(result == VK_SUCCESS);
+    #endif
+
+    // eg. "VULCAIN_HEADLESS=1000" renders 1000 frames offscreen
+    if(auto framesCount = getenv("VULCAIN_HEADLESS")) {
+        return headless(std::stoull(framesCount));
+    }
+    
+    GlfwWindow window;
+
+    auto appInfo = info("Hello Triangle");
+    InstanceCreateInfo createInfo(&appInfo);
+    Instance instance(&createInfo);
+    Surface surface(&window, &instance);
+    auto device = DevicePicker::getBestDevice(&surface);
+    UploadQueue uploads(&device);
+    
+    // interactive stations would rather minimize input latency
+    auto settings = getenv("VULCAIN_LOW_LATENCY") ? RenderSettings::lowLatency() : RenderSettings{};
+    Swapchain swapchain(&device, settings);
+
+    drawQuad(&swapchain, &uploads, false, [&window, &swapchain](CommandPool* cmdPool) {
+        return std::make_unique<Renderer>(cmdPool, &window, &swapchain);
+    }, [&window](Renderer&) {
+        window.pollEventsAndDraw();
+    });
 
     return 0;
-}
\ No newline at end of file
+}
@@ -24,6 +24,11 @@
 
 #include <magic_enum.hpp>
 
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+#include <string>
+
 class Output {
  public:
     static std::vector<std::filesystem::path> generate(ReflectionPass &pass, const Args &args) {
@@ -34,15 +39,19 @@ class Output {
             //
             auto outputPath = _generateCppFilePath(pipelineName, args.destinationDirectory);
 
+            // every stage of a pipeline ends up in the same file
+            std::ofstream stream(outputPath.string().c_str(), std::ofstream::trunc);
+            _fillStreamHeader(stream);
+
             //
+            std::set<std::string> declaredUBs;
             for(auto const & rFile : rFiles) {
-                if(!rFile.uniformBuffers.size()) continue;
-
-                //
-                std::ofstream stream(outputPath.string().c_str(), std::ofstream::trunc);
-                _fillStreamFromReflectedFile(stream, rFile);
+                _fillStreamFromReflectedFile(stream, rFile, declaredUBs);
             }
 
+            //
+            _fillStreamFromPipeline(stream, pipelineName, rFiles);
+
             // add to results
             out.emplace_back(outputPath);
         }
@@ -51,26 +60,149 @@ class Output {
     }
  
  private:
-    static std::filesystem::path _generateCppFilePath(const char* pipelineName, const std::filesystem::path &outputDirectoryPath) {
+    static std::filesystem::path _generateCppFilePath(const std::string& pipelineName, const std::filesystem::path &outputDirectoryPath) {
         auto temp = outputDirectoryPath / pipelineName;
         return temp.replace_extension(".hpp");
     }
 
-    static void _fillStreamFromReflectedFile(std::ofstream& outStream, const ReflectedFile &rFile) {
+    static void _fillStreamHeader(std::ofstream& outStream) {
         //
         outStream << "// This file is autogenerated" << "\n\n";
 
         //
+        outStream << "#pragma once" << "\n\n";
         outStream << "#include \"generator/include/IDescriptorSetGenerator.h\"" << '\n';
         outStream << '\n';
+        outStream << "#include <array>" << '\n';
+        outStream << "#include <cstddef>" << '\n';
+        outStream << '\n';
+    }
+
+    static void _fillStreamFromReflectedFile(std::ofstream& outStream, const ReflectedFile &rFile, std::set<std::string> &declaredUBs) {
+        _fillStreamFromReflectedUBs(outStream, rFile.uniformBuffers, rFile.stage, declaredUBs);
+    }
+
+    // pipeline tag, used to pick shaders and vertex layout at compile time
+    static void _fillStreamFromPipeline(std::ofstream& outStream, const std::string& pipelineName, const std::vector<ReflectedFile> &rFiles) {
+        //
+        auto vertexStage = std::find_if(rFiles.begin(), rFiles.end(), [](const ReflectedFile& rFile) {
+            return rFile.stage == VK_SHADER_STAGE_VERTEX_BIT;
+        });
+
+        auto vertexStructName = pipelineName + "Vertex";
+        auto hasVertexInputs = vertexStage != rFiles.end() && vertexStage->stageInputs.size();
+        if(hasVertexInputs) {
+            _fillStreamFromStageInputs(outStream, vertexStructName, vertexStage->stageInputs);
+        }
 
         //
-        _fillStreamFromReflectedUBs(outStream, rFile.uniformBuffers, rFile.stage);
+        outStream << "namespace Pipelines {" << '\n';
+        outStream << "struct " << pipelineName << " {" << '\n';
+            if(hasVertexInputs) {
+                outStream << '\t' << "using Vertex = " << vertexStructName << ';' << '\n';
+            }
+            outStream << '\t' << "static constexpr const char* name = \"" << pipelineName << "\";" << '\n';
+            _fillTagFromResources(outStream, rFiles);
+        outStream << "};" << '\n';
+        outStream << "} // namespace Pipelines" << '\n';
     }
 
-    static void _fillStreamFromReflectedUBs(std::ofstream& outStream, const UniformBuffersFiller::Container &container, VkShaderStageFlagBits stage) {
+    // layout of storage buffers and push constants shared by all stages, and workgroup size of compute pipelines
+    static void _fillTagFromResources(std::ofstream& outStream, const std::vector<ReflectedFile> &rFiles) {
+        // stages using the same binding share its descriptor
+        std::map<uint32_t, std::pair<const SB*, std::vector<VkShaderStageFlagBits>>> storageBuffers;
+        uint32_t pushConstantsSize = 0;
+        for(auto const &rFile : rFiles) {
+            for(auto const &sb : rFile.storageBuffers) {
+                // "ComputePipeline" creates a single descriptor set layout out of the generated table
+                if(sb.set != 0) {
+                    throw std::logic_error("Unsupported descriptor set " + std::to_string(sb.set) + " for storage buffer [" + sb.name + "], only set 0 is handled");
+                }
+
+                //
+                auto &[declared, stages] = storageBuffers[sb.binding];
+                declared = &sb;
+                stages.push_back(rFile.stage);
+            }
+            pushConstantsSize = std::max(pushConstantsSize, rFile.pushConstantsSize);
+        }
+
+        //
+        outStream << '\t' << "static constexpr uint32_t pushConstantsSize = " << pushConstantsSize << ';' << '\n';
+
+        //
+        outStream << '\t' << "static constexpr std::array<VkDescriptorSetLayoutBinding, " << storageBuffers.size() << "> storageBuffers {{" << '\n';
+            for(auto const &[binding, usage] : storageBuffers) {
+                auto const &[sb, stages] = usage;
+                outStream << "\t\t" << "{ " << binding << ", VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, ";
+                for(size_t i = 0; i < stages.size(); i++) {
+                    outStream << (i ? " | " : "") << magic_enum::enum_name(stages[i]);
+                }
+                outStream << ", nullptr }, // " << sb->name << (sb->readonly ? ", readonly" : "") << '\n';
+            }
+        outStream << '\t' << "}};" << '\n';
+
+        //
+        auto computeStage = std::find_if(rFiles.begin(), rFiles.end(), [](const ReflectedFile& rFile) {
+            return rFile.stage == VK_SHADER_STAGE_COMPUTE_BIT;
+        });
+        if(computeStage != rFiles.end()) {
+            auto &size = computeStage->workgroupSize;
+            outStream << '\t' << "static constexpr std::array<uint32_t, 3> workgroupSize { " << size[0] << ", " << size[1] << ", " << size[2] << " };" << '\n';
+        }
+    }
+
+    // tightly packed vertex struct, matching vertex shader inputs
+    static void _fillStreamFromStageInputs(std::ofstream& outStream, const std::string& structName, const StageInputsFiller::Container &attributes) {
+        //
+        uint32_t stride = 0;
+        for(auto const &attribute : attributes) {
+            stride += attribute.size;
+        }
+
+        //
+        outStream << "struct " << structName << " {" << '\n';
+
+            //
+            for(auto const &attribute : attributes) {
+                outStream << '\t' << attribute.type << ' ' << attribute.name << ';' << '\n';
+            }
+
+            //
+            outStream << '\n';
+            outStream << '\t' << "static constexpr VkVertexInputBindingDescription bindingDescription { 0, " << stride << ", VK_VERTEX_INPUT_RATE_VERTEX };" << '\n';
+            outStream << '\t' << "static constexpr std::array<VkVertexInputAttributeDescription, " << attributes.size() << "> attributeDescriptions {{" << '\n';
+                uint32_t offset = 0;
+                for(auto const &attribute : attributes) {
+                    outStream << "\t\t" << "{ " << attribute.location << ", 0, " << attribute.format << ", " << offset << " }," << '\n';
+                    offset += attribute.size;
+                }
+            outStream << '\t' << "}};" << '\n';
+
+            //
+            outStream << '\n';
+            outStream << '\t' << "static VkVertexInputBindingDescription getBindingDescription() { return bindingDescription; }" << '\n';
+            outStream << '\t' << "static std::array<VkVertexInputAttributeDescription, " << attributes.size() << "> getAttributeDescriptions() { return attributeDescriptions; }" << '\n';
+
+        //
+        outStream << "};" << '\n';
+
+        // layout guards against compiler padding
+        outStream << "static_assert(sizeof(" << structName << ") == " << stride << ", \"" << structName << " must be tightly packed\");" << '\n';
+        uint32_t offset = 0;
+        for(auto const &attribute : attributes) {
+            outStream << "static_assert(offsetof(" << structName << ", " << attribute.name << ") == " << offset << ");" << '\n';
+            offset += attribute.size;
+        }
+        outStream << '\n';
+    }
+
+    static void _fillStreamFromReflectedUBs(std::ofstream& outStream, const UniformBuffersFiller::Container &container, VkShaderStageFlagBits stage, std::set<std::string> &declaredUBs) {
         //
         for(auto const &ub: container) {
+            // already declared by another stage of the pipeline
+            if(!declaredUBs.insert(ub.name).second) continue;
+
             //
             outStream << "struct " << ub.name << " {" << '\n';
 
@@ -93,6 +225,7 @@ class Output {
 
             //
             outStream << "};" << '\n';
+            outStream << '\n';
         }
     }
 };
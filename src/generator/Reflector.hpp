@@ -23,8 +23,11 @@
 
 #include "Args.hpp"
 #include "reflection/UniformBuffers.hpp"
+#include "reflection/StageInputs.hpp"
+#include "reflection/StorageBuffers.hpp"
 
 #include <map>
+#include <array>
 #include <utility>
 #include <fstream>
 #include <iterator>
@@ -32,14 +35,19 @@
 struct ReflectedFile {
     VkShaderStageFlagBits stage;
     UniformBuffersFiller::Container uniformBuffers;
+    StageInputsFiller::Container stageInputs;
+    StorageBuffersFiller::Container storageBuffers;
+    uint32_t pushConstantsSize = 0;
+    std::array<uint32_t, 3> workgroupSize {}; // compute stage only
 };
 
-using ReflectionPass = std::map<const char *, std::vector<ReflectedFile>>;
+using ReflectionPass = std::map<std::string, std::vector<ReflectedFile>>;
 
 const std::map<const char*, VkShaderStageFlagBits> FIND_STAGE_FROM_EXT {
     { ".vert", VK_SHADER_STAGE_VERTEX_BIT },
     { ".frag", VK_SHADER_STAGE_FRAGMENT_BIT },
-    { ".geom", VK_SHADER_STAGE_GEOMETRY_BIT }
+    { ".geom", VK_SHADER_STAGE_GEOMETRY_BIT },
+    { ".comp", VK_SHADER_STAGE_COMPUTE_BIT }
 };
 
 class Reflector {
@@ -60,11 +68,11 @@ class Reflector {
             _reflectShaderFile(filePath, rFile);
 
             // insert into pass
-            auto pipelineFound = pass.find(filename.c_str());
+            auto pipelineFound = pass.find(filename);
             if(pipelineFound == pass.cend()) {
                 std::vector<ReflectedFile> v(1);
                 v[0] = std::move(rFile);
-               pass.emplace(filename.c_str(), std::move(v));
+               pass.emplace(filename, std::move(v));
             } else {
                 pipelineFound->second.push_back(std::move(rFile));
             }
@@ -90,6 +98,23 @@ class Reflector {
 
         // fill
         UniformBuffersFiller::fillMetadata(comp, resources, glslComp, rFile.uniformBuffers);
+        if(rFile.stage == VK_SHADER_STAGE_VERTEX_BIT) {
+            StageInputsFiller::fillMetadata(comp, resources, glslComp, rFile.stageInputs);
+        }
+        StorageBuffersFiller::fillMetadata(comp, resources, glslComp, rFile.storageBuffers);
+
+        // a single push constant block per stage
+        if(resources.push_constant_buffers.size()) {
+            auto &pushConstants = resources.push_constant_buffers[0];
+            rFile.pushConstantsSize = static_cast<uint32_t>(comp.get_declared_struct_size(comp.get_type(pushConstants.base_type_id)));
+        }
+
+        // local_size_x/y/z
+        if(rFile.stage == VK_SHADER_STAGE_COMPUTE_BIT) {
+            for(uint32_t i = 0; i < rFile.workgroupSize.size(); i++) {
+                rFile.workgroupSize[i] = comp.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+            }
+        }
     }
 
     static std::vector<uint32_t> _readFile(const std::filesystem::path &filePath) {
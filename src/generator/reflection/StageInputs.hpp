@@ -0,0 +1,118 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "IFiller.hpp"
+
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+struct SI_Attribute {
+    std::string name;
+    std::string type; // C++ type of the matching vertex struct member
+    std::string format; // VkFormat, as written in generated code
+    uint32_t location = 0;
+    uint32_t size = 0;
+};
+
+// vertex shader inputs, ordered by location
+class StageInputsFiller : public IFiller<StageInputsFiller, SI_Attribute> {
+ public:
+    static void fillMetadata(spirv_cross::Compiler &comp, spirv_cross::ShaderResources &resources, GLSLCompilerWrapper &, IFiller::Container &attributes) {
+        attributes.clear();
+        attributes.reserve(resources.stage_inputs.size());
+
+        //
+        for (auto &input : resources.stage_inputs) {
+            // gl_VertexIndex and such are not fed by vertex buffers
+            if(comp.has_decoration(input.id, spv::DecorationBuiltIn)) continue;
+
+            //
+            auto &type = comp.get_type(input.type_id);
+            auto location = comp.get_decoration(input.id, spv::DecorationLocation);
+            auto [scalarType, formatPrefix, formatSuffix] = _scalar(type, input.name);
+
+            // arrays take a location per element, and matrices a location per column of each element
+            auto elements = _elementsCount(type, input.name);
+            for (uint32_t element = 0; element < elements; element++) {
+                for (uint32_t column = 0; column < type.columns; column++) {
+                    auto &attribute = attributes.emplace_back();
+                    attribute.location = location + element * type.columns + column;
+                    attribute.size = type.vecsize * 4;
+                    attribute.format = _format(type.vecsize, formatSuffix);
+
+                    //
+                    attribute.name = input.name;
+                    if(!type.array.empty()) attribute.name += "_" + std::to_string(element);
+                    if(type.columns > 1) attribute.name += "_" + std::to_string(column);
+
+                    //
+                    attribute.type = type.vecsize == 1 && type.columns == 1 ? scalarType : "glm::" + formatPrefix + "vec" + std::to_string(type.vecsize);
+                }
+            }
+        }
+
+        //
+        std::sort(attributes.begin(), attributes.end(), [](const SI_Attribute& a, const SI_Attribute& b) {
+            return a.location < b.location;
+        });
+    }
+
+ private:
+    struct Scalar {
+        std::string type;
+        std::string vectorPrefix;
+        std::string formatSuffix;
+    };
+
+    // only 32 bits components, which keep vertex structs tightly packed
+    static Scalar _scalar(const spirv_cross::SPIRType &type, const std::string &inputName) {
+        using BaseType = spirv_cross::SPIRType::BaseType;
+        switch(type.basetype) {
+            case BaseType::Float:
+                return { "float", "", "SFLOAT" };
+            case BaseType::Int:
+                return { "int32_t", "i", "SINT" };
+            case BaseType::UInt:
+                return { "uint32_t", "u", "UINT" };
+            default:
+                throw std::logic_error("Unsupported type for vertex input [" + inputName + "], only 32 bits scalars and vectors are handled");
+        }
+    }
+
+    // flattened size of (possibly multidimensional) arrays, 1 otherwise
+    static uint32_t _elementsCount(const spirv_cross::SPIRType &type, const std::string &inputName) {
+        uint32_t elements = 1;
+        for (size_t dimension = 0; dimension < type.array.size(); dimension++) {
+            if(!type.array_size_literal[dimension] || !type.array[dimension]) {
+                throw std::logic_error("Unsupported array size for vertex input [" + inputName + "], only sizes known at compile time are handled");
+            }
+            elements *= type.array[dimension];
+        }
+        return elements;
+    }
+
+    static std::string _format(uint32_t vecsize, const std::string &suffix) {
+        static const char* COMPONENTS[] = { "R32", "R32G32", "R32G32B32", "R32G32B32A32" };
+        return std::string("VK_FORMAT_") + COMPONENTS[vecsize - 1] + "_" + suffix;
+    }
+};
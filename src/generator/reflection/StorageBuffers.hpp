@@ -0,0 +1,56 @@
+// Vulcain
+// Toy project for Vulkan oriented graphics
+// Copyright (C) 2021 Guillaume Vara <guillaume.vara@gmail.com>
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Any graphical resources available within the source code may
+// use a different license and copyright : please refer to their metadata
+// for further details. Graphical resources without explicit references to a
+// different license and copyright still refer to this GPL.
+
+
+#pragma once
+
+#include "IFiller.hpp"
+
+#include <string>
+#include <algorithm>
+
+struct SB {
+    std::string name;
+    uint32_t binding = 0;
+    uint32_t set = 0;
+    bool readonly = false;
+};
+
+// shader storage blocks, ordered by binding
+class StorageBuffersFiller : public IFiller<StorageBuffersFiller, SB> {
+ public:
+    static void fillMetadata(spirv_cross::Compiler &comp, spirv_cross::ShaderResources &resources, GLSLCompilerWrapper &, IFiller::Container &sbs) {
+        sbs.clear();
+        sbs.reserve(resources.storage_buffers.size());
+
+        //
+        for (auto &s_source : resources.storage_buffers) {
+            auto &sb = sbs.emplace_back();
+            sb.name = s_source.name;
+            sb.binding = comp.get_decoration(s_source.id, spv::DecorationBinding);
+            sb.set = comp.get_decoration(s_source.id, spv::DecorationDescriptorSet);
+            sb.readonly = comp.get_buffer_block_flags(s_source.id).get(spv::DecorationNonWritable);
+        }
+
+        //
+        std::sort(sbs.begin(), sbs.end(), [](const SB& a, const SB& b) {
+            return a.binding < b.binding;
+        });
+    }
+};